@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "cyber.h"
+
+// Measures the overhead of calling a script function from the host with `clCall`.
+// zig cc -O2 call_bench.c -I ../../src/include ../../zig-out/lib/libcyber.a -o call_bench
+
+#define STR(s) ((CLStr){ s, strlen(s) })
+#define N 1000000
+
+static double nowSecs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void printError(CLVM* vm) {
+    CLStr s = clNewLastErrorSummary(vm);
+    printf("%.*s\n", (int)s.len, s.ptr);
+    clFree(vm, s);
+}
+
+int main() {
+    CLVM* vm = clCreate();
+
+    // Baseline: the same calls made from a script loop. This also includes compiling the
+    // few lines below, which is small next to the loop.
+    CLStr src = STR(
+        "func add(a int, b int) int:\n"
+        "    return a + b\n"
+        "var sum = 0\n"
+        "for 0..1000000 -> i:\n"
+        "    sum = add(sum, 1)\n"
+        "sum\n"
+    );
+    CLValue val;
+    double start = nowSecs();
+    if (clEval(vm, src, &val) != CL_SUCCESS) {
+        printError(vm);
+        clDestroy(vm);
+        return 1;
+    }
+    double script_secs = nowSecs() - start;
+    clRelease(vm, val);
+
+    CLValue func;
+    if (!clFindFunc(vm, STR("add"), &func)) {
+        printf("Missing `add`.\n");
+        clDestroy(vm);
+        return 1;
+    }
+
+    // Host loop: one `clCall` per iteration with a reused handle.
+    CLValue args[2] = { clNewInt(vm, 0), clNewInt(vm, 1) };
+    start = nowSecs();
+    for (int i = 0; i < N; i += 1) {
+        CLValue res;
+        if (clCall(vm, func, args, 2, &res) != CL_SUCCESS) {
+            printError(vm);
+            break;
+        }
+        clRelease(vm, args[0]);
+        args[0] = res;
+    }
+    double host_secs = nowSecs() - start;
+    printf("sum: %lld\n", (long long)clAsBoxInt(args[0]));
+    clRelease(vm, args[0]);
+    clRelease(vm, args[1]);
+    clRelease(vm, func);
+
+    printf("script loop: %.1f ns/call\n", script_secs * 1e9 / N);
+    printf("clCall loop: %.1f ns/call\n", host_secs * 1e9 / N);
+    printf("host overhead: %.1f ns/call\n", (host_secs - script_secs) * 1e9 / N);
+    clDestroy(vm);
+    return 0;
+}
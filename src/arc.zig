@@ -264,6 +264,8 @@ fn performSweep(vm: *cy.VM) !c.GCResult {
     const num_freed: u32 = 0;
     var num_cyc_freed: u32 = 0;
 
+    cy.heap.flushBumpSpan(vm);
+
     log.tracev("Sweep heap pages.", .{});
     for (vm.heapPages.items()) |page| {
         var i: u32 = 1;
@@ -316,6 +318,10 @@ fn performSweep(vm: *cy.VM) !c.GCResult {
 
     if (cy.Trace) {
         vm.c.trace.numCycFrees += num_cyc_freed;
+    } else {
+        // Coalesce the free slots left by the sweep and by `freePoolObject` since the last gc,
+        // and release pages that are fully free. Trace mode keeps its LRU free list.
+        cy.heap.rebuildFreeSpans(vm);
     }
 
     const res = c.GCResult{
@@ -420,7 +426,7 @@ fn markValue(vm: *cy.VM, v: cy.Value) void {
             } else if (entry.kind == .func_union) {
                 const vals = obj.func_union.getCapturedValuesPtr()[0..obj.func_union.data.closure.numCaptured];
                 for (vals) |val| {
-                    // TODO: Can this be assumed to always be a Box value?
+                    // Either an `UpValue` or a var captured by value.
                     if (val.isCycPointer()) {
                         markValue(vm, val);
                     }
@@ -441,6 +447,7 @@ fn markValue(vm: *cy.VM, v: cy.Value) void {
 }
 
 pub fn countObjects(vm: *cy.VM) usize {
+    cy.heap.flushBumpSpan(vm);
     var count: usize = 0;
     for (vm.heapPages.items()) |page| {
         var i: u32 = 1;
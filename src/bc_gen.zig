@@ -91,14 +91,14 @@ pub fn genAll(c: *cy.Compiler) !void {
             switch (sym.type) {
                 .object_t => {
                     // rt funcs have been reserved. Create impl vtables.
+                    // Entries are copied from `funcSyms` after codegen.
                     const object_t = sym.cast(.object_t);
                     for (object_t.impls()) |impl| {
-                        const vtable = try c.alloc.alloc(u32, impl.funcs.len);
-                        for (impl.funcs, 0..) |func, i| {
-                            vtable[i] = c.genSymMap.get(func).?.func.id;
-                        }
-                        const vtable_idx = c.vm.vtables.len;
-                        try c.vm.vtables.append(c.alloc, vtable);
+                        const vtable = try c.alloc.alloc(rt.FuncSymbol, impl.funcs.len);
+                        @memset(vtable, rt.FuncSymbol.initNull());
+                        const vtables = c.vm.c.getVtables();
+                        const vtable_idx = vtables.len;
+                        try vtables.append(c.alloc, vtable);
                         try c.gen_vtables.put(c.alloc, VtableKey{ .type = object_t.type, .trait = impl.trait.type }, @intCast(vtable_idx));
                     }
                 },
@@ -131,6 +131,23 @@ pub fn genAll(c: *cy.Compiler) !void {
         log.tracev("Done. performChunkCodegen {s}", .{chunk.srcUri});
     }
 
+    // Funcs are complete. Fill impl vtables.
+    for (c.newChunks()) |chunk| {
+        for (chunk.syms.items) |sym| {
+            if (sym.type != .object_t) {
+                continue;
+            }
+            const object_t = sym.cast(.object_t);
+            for (object_t.impls()) |impl| {
+                const vtable_idx = c.gen_vtables.get(VtableKey{ .type = object_t.type, .trait = impl.trait.type }).?;
+                const vtable = c.vm.c.getVtables().buf[vtable_idx];
+                for (impl.funcs, 0..) |func, i| {
+                    vtable[i] = c.vm.funcSyms.buf[c.genSymMap.get(func).?.func.id];
+                }
+            }
+        }
+    }
+
     // Merge inst and const buffers.
     const reqLen = c.buf.ops.items.len + c.buf.consts.items.len * @sizeOf(cy.Value) + @alignOf(cy.Value) - 1;
     if (c.buf.ops.capacity < reqLen) {
@@ -1750,6 +1767,14 @@ fn genBox(c: *Chunk, idx: usize, cstr: Cstr, node: *ast.Node) !GenValue {
     }
 }
 
+/// Captures that sema did not lift were copied into the closure by value.
+/// The parent proc is still on the stack, so its slot for the capture is checked.
+fn isCapturedUpValue(c: *Chunk, idx: u8) bool {
+    const parent = c.proc_stack.items[c.proc_stack.items.len-2];
+    const slot = c.genIrLocalMapStack.items[parent.irLocalMapStart + c.curBlock.captures[idx]];
+    return c.slot_stack.items[parent.slot_start + slot].boxed_up;
+}
+
 fn genCaptured(c: *Chunk, idx: usize, cstr: Cstr, node: *ast.Node) !GenValue {
     const data = c.ir.getExprData(idx, .captured);
 
@@ -1760,7 +1785,8 @@ fn genCaptured(c: *Chunk, idx: usize, cstr: Cstr, node: *ast.Node) !GenValue {
         try pushRelease(c, inst.dst, node);
     }
 
-    try c.pushCode(.captured, &.{ c.curBlock.closureLocal, data.idx, @intFromBool(retain), inst.dst }, node);
+    const code: cy.OpCode = if (isCapturedUpValue(c, data.idx)) .captured else .captured_value;
+    try c.pushCode(code, &.{ c.curBlock.closureLocal, data.idx, @intFromBool(retain), inst.dst }, node);
     if (inst.own_dst) {
         try initSlot(c, inst.dst, retain, node);
     }
@@ -2827,6 +2853,7 @@ fn forRangeStmt(c: *Chunk, idx: usize, node: *ast.Node) !void {
     const forRangeOp = c.buf.ops.items.len;
     // The forRange op is patched by forRangeInit at runtime.
     c.buf.setOpArgU16(initPc + 6, @intCast(c.buf.ops.items.len - initPc));
+    try c.pushOptionalDebugSym(node);
     try c.pushCode(.forRange, &.{ counter, rangeEnd, eachLocal, 0, 0 }, node);
     c.buf.setOpArgU16(forRangeOp + 4, jumpBackOffset);
 
@@ -2988,6 +3015,8 @@ fn genIfStmt(c: *cy.Chunk, idx: usize, node: *ast.Node) !void {
     const condv = try genExpr(c, data.cond, Cstr.simple);
     try initTempValue(c, condv, node);
 
+    // Locates the branch in a profile.
+    try c.pushOptionalDebugSym(node);
     const jump_miss = try c.pushEmptyJumpNotCond(condv.reg);
 
     try pushBlock(c, false, node);
@@ -3023,6 +3052,7 @@ fn elseBlocks(c: *cy.Chunk, else_head: u32) !void {
             const condv = try genExpr(c, else_b.cond, Cstr.simple);
             try initTempValue(c, condv, condNodeId);
 
+            try c.pushOptionalDebugSym(else_nid);
             const jump_miss = try c.pushEmptyJumpNotCond(condv.reg);
 
             try pushBlock(c, false, else_nid);
@@ -3356,6 +3386,9 @@ fn genLambda(c: *Chunk, idx: usize, cstr: Cstr, node: *ast.Node) !GenValue {
     log.tracev("push lambda block: {}, {}", .{func.numParams, data.maxLocals});
     const funcPc = c.buf.ops.items.len;
     try pushFuncBlockCommon(c, data.maxLocals, data.numParamCopies, params, func, node);
+    if (data.numCaptures > 0) {
+        c.curBlock.captures = c.ir.getArray(data.captures, u8, data.numCaptures);
+    }
 
     try genStmts(c, data.bodyHead);
 
@@ -3522,6 +3555,9 @@ pub const Proc = struct {
     /// contains the closure's value which is then used to perform captured var lookup.
     closureLocal: u8,
 
+    /// IR local ids in the parent proc for each captured var.
+    captures: []align(1) const u8,
+
     /// Starts after the prelude registers.
     startLocalReg: u8,
 
@@ -3549,6 +3585,7 @@ pub const Proc = struct {
             .type = btype,
             .requiresEndingRet1 = false,
             .closureLocal = cy.NullU8,
+            .captures = &.{},
             .irLocalMapStart = 0,
             .slot_start = 0,
             .num_pre_slots = 0,
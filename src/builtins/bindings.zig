@@ -56,6 +56,7 @@ pub const Symbol = enum {
     MissingSymbol,
     EndOfStream,
     OutOfBounds,
+    ParseError,
     InvalidResult,
     InvalidArgument,
     InvalidSignature,
@@ -116,32 +117,86 @@ fn ensureSymbol(vm: *cy.VM, name: []const u8, sym: Symbol) !void {
     std.debug.assert(id == @intFromEnum(sym));
 }
 
-// TODO: Provide sort where the sort fields and compare strategy are provided instead of a lessFn,
-//       since Cyber's VM is non reentrant.
-pub fn listSort(vm: *cy.VM, args: [*]const Value, nargs: u8) Value {
-    const obj = args[0].asHeapObject();
-    const list = cy.ptrAlignCast(*cy.List(Value), &obj.list.list);
-    const LessContext = struct {
-        lessFn: Value,
-        vm: *cy.UserVM,
-        newFramePtr: u32,
-    };
-    var lessCtx = LessContext{
-        .lessFn = args[1],
-        .vm = vm,
-        .newFramePtr = vm.getNewFramePtrOffset(args, nargs),
+/// Stable sort (block sort), calling `lessFn` through a `PreparedCall` so that only the
+/// args are copied per comparison.
+pub fn listSort(vm: *cy.VM) anyerror!Value {
+    const elem_t: cy.TypeId = @intCast(vm.getInt(1));
+    const obj = vm.getValue(0).asHeapObject();
+    const inner = cy.ptrAlignCast(*cy.List(Value), &obj.list.list);
+    if (inner.len < 2) {
+        return Value.Void;
+    }
+
+    // Detach the elements so that `lessFn` can't invalidate them by modifying the list.
+    const elems = inner.*;
+    inner.* = .{};
+    defer {
+        for (inner.items()) |item| {
+            vm.release(item);
+        }
+        inner.deinit(vm.alloc);
+        inner.* = elems;
+    }
+
+    // Dynamic calls expect boxed args, so unboxed elements are boxed once up front
+    // instead of on every comparison.
+    const unboxed = vm.sema.isUnboxedType(elem_t);
+    var items = elems.items();
+    if (unboxed) {
+        items = try vm.alloc.alloc(Value, elems.len);
+        var n: usize = 0;
+        errdefer {
+            for (items[0..n]) |item| {
+                vm.release(item);
+            }
+            vm.alloc.free(items);
+        }
+        for (elems.items()) |elem| {
+            items[n] = try vm.allocBoxValue(elem_t, elem.val);
+            n += 1;
+        }
+    }
+    defer if (unboxed) {
+        for (items, elems.items()) |item, *elem| {
+            elem.* = vm_.unbox(vm, item, elem_t);
+            vm.release(item);
+        }
+        vm.alloc.free(items);
     };
 
-    const S = struct {
-        fn less(ctx_: *LessContext, a: Value, b: Value) bool {
-            const res = ctx_.vm.callFunc(ctx_.newFramePtr, ctx_.lessFn, &.{a, b}) catch {
+    const LessContext = struct {
+        vm: *cy.VM,
+        call: vm_.PreparedCall,
+        err: ?anyerror,
+
+        fn less(ctx: *@This(), a: Value, b: Value) bool {
+            if (ctx.err != null) {
+                return false;
+            }
+            const res = ctx.call.call(ctx.vm, &.{a, b}) catch |err| {
+                ctx.err = err;
                 return false;
             };
-            return res.toBool();
+            return res.asBool();
         }
     };
-    std.sort.pdq(Value, list.items(), &lessCtx, S.less);
-    return Value.None;
+    var ctx = LessContext{
+        .vm = vm,
+        .call = try vm.prepareCall(vm.getValue(2), 2),
+        .err = null,
+    };
+    // Block sort is stable and doesn't allocate.
+    std.sort.block(Value, items, &ctx, LessContext.less);
+    if (ctx.err) |err| {
+        if (err == error.Panic) {
+            return Value.Interrupt;
+        }
+        return err;
+    }
+    if (inner.len > 0) {
+        return vm.prepPanic("List was modified during sort.");
+    }
+    return Value.Void;
 }
 
 pub fn listRemove(vm: *cy.VM) Value {
@@ -312,52 +367,22 @@ pub fn listJoin(vm: *cy.VM) anyerror!Value {
     const obj = vm.getValue(0).asHeapObject();
     const items = obj.list.items();
     if (items.len > 0) {
-        var is_ascii = vm.getObject(*cy.heap.String, 1).getType().isAstring();
-        const sep = vm.getString(1);
-
-        // First record length.
-        var byteLen: u32 = 0;
-        var out_ascii: bool=  undefined;
-
-        // Record first string part.
-        var str = try vm.getOrBufPrintValueStr2(&cy.tempBuf, items[0], &out_ascii);
-        is_ascii = is_ascii and out_ascii;
-        byteLen += @intCast(str.len);
-
-        // Record other string parts.
-        for (items[1..]) |item| {
-            str = try vm.getOrBufPrintValueStr2(&cy.tempBuf, item, &out_ascii);
-            is_ascii = is_ascii and out_ascii;
-            byteLen += @intCast(str.len);
-        }
-        byteLen += @intCast(sep.len * (items.len-1));
-
-        // Allocate final buffer and perform join.
-        var newObj: *cy.HeapObject = undefined;
-        var buf: []u8 = undefined;
-
-        if (is_ascii) {
-            newObj = try vm.allocUnsetAstringObject(byteLen);
-            buf = newObj.astring.getMutSlice();
-        } else {
-            newObj = try vm.allocUnsetUstringObject(byteLen);
-            buf = newObj.ustring.getMutSlice();
-        }
-
-        // Copy.
-        str = try vm.getOrBufPrintValueStr(&cy.tempBuf, items[0]);
-        @memcpy(buf[0..str.len], str);
-
-        var dst: usize = str.len;
-        for (items[1..]) |item| {
-            @memcpy(buf[dst..dst+sep.len], sep);
-            dst += sep.len;
-
-            str = try vm.getOrBufPrintValueStr(&cy.tempBuf, item);
-            @memcpy(buf[dst..dst+str.len], str);
-            dst += str.len;
+        const sep_obj = vm.getObject(*cy.heap.String, 1);
+        const sep = sep_obj.getSlice();
+        const sep_ascii = sep_obj.getType().isAstring();
+
+        // Format each element once directly into the final buffer.
+        var sb = try cy.string.HeapStringBuilder.init(vm);
+        errdefer sb.deinit();
+        for (items, 0..) |item, i| {
+            if (i > 0) {
+                try sb.appendString2(sep, sep_ascii);
+            }
+            var out_ascii: bool = undefined;
+            const str = try vm.getOrBufPrintValueStr2(&cy.tempBuf, item, &out_ascii);
+            try sb.appendString2(str, out_ascii);
         }
-        return Value.initNoCycPtr(newObj);
+        return sb.buildOwned();
     } else {
         const empty = vm.emptyString;
         vm.retain(empty);
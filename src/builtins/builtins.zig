@@ -25,6 +25,10 @@ pub const CoreData = struct {
     VMT: cy.TypeId,
     EvalResultT: cy.TypeId,
     EvalConfigT: cy.TypeId,
+    Float32ArrayT: cy.TypeId,
+    Float64ArrayT: cy.TypeId,
+    Int64ArrayT: cy.TypeId,
+    JsonDocT: cy.TypeId,
 };
 
 const func = cy.hostFuncEntry;
@@ -131,7 +135,7 @@ const funcs = [_]C.HostFuncEntry{
     func("List.len",         bindings.listLen),
     func("List.remove",      bindings.listRemove),
     func("List.resize_",     zErrFunc(bindings.listResize)),
-    // .{"sort", bindings.listSort, .standard},
+    func("List.sort_",       zErrFunc(bindings.listSort)),
     func("List.fill_",       listFill),
 
     // ListIterator
@@ -175,8 +179,9 @@ const funcs = [_]C.HostFuncEntry{
     func("MapIterator.next",   bindings.mapIteratorNext),
 
     // String
-    func("String.$infix+",     string.concat),
-    func("String.concat",      string.concat),
+    func("String.$infix+",     zErrFunc(string.concat)),
+    func("String.appendInPlace_", zErrFunc(string.appendInPlace)),
+    func("String.concat",      zErrFunc(string.concat)),
     func("String.count",       string.count),
     // func("String.decode",       String_decode),
     // func("String.decode2",      String_decode2),
@@ -192,22 +197,36 @@ const funcs = [_]C.HostFuncEntry{
     func("String.getInt32",    zErrFunc(String_getInt32)),
     func("String.insert",      zErrFunc(string.insertFn)),
     func("String.insertByte",  zErrFunc(string.insertByte)),
+    func("String.intern",      string.intern),
     func("String.isAscii",     string.isAscii),
     func("String.len",         string.lenFn),
     func("String.less",        string.less),
     func("String.lower",       string.lower),
     func("String.replace",     string.stringReplace),
-    func("String.repeat",      string.repeat),
+    func("String.repeat",      zErrFunc(string.repeat)),
     func("String.seek",        zErrFunc(string.seek)),
     func("String.sliceAt",     zErrFunc(string.sliceAt)),
     func("String.$index",      zErrFunc(string.runeAt)),
     func("String.$indexRange", string.sliceFn),
     func("String.split",       zErrFunc(string.split)),
+    func("String.split2",      zErrFunc(string.split2)),
+    func("String.splitIter",   zErrFunc(string.splitIter)),
     func("String.startsWith",  string.startsWith),
     func("String.trim",        string.trim),
     func("String.upper",       string.upper),
     func("String.$call",       zErrFunc(string.stringCall)),
 
+    // StringBuilder
+    func("StringBuilder.append",     zErrFunc(string.StringBuilder_append)),
+    func("StringBuilder.appendByte", zErrFunc(string.StringBuilder_appendByte)),
+    func("StringBuilder.appendFmt",  zErrFunc(string.StringBuilder_appendFmt)),
+    func("StringBuilder.build",      zErrFunc(string.StringBuilder_build)),
+    func("StringBuilder.len",        string.StringBuilder_len),
+    func("StringBuilder.new",        zErrFunc(string.StringBuilder_new)),
+
+    // StringSplitIterator
+    func("StringSplitIterator.next", zErrFunc(string.StringSplitIterator_next)),
+
     // Array
     // func("Array.$infix+",      arrayConcat),
     // func("Array.concat",       arrayConcat),
@@ -251,6 +270,16 @@ const funcs = [_]C.HostFuncEntry{
     func("FutureResolver.future",   zErrFunc(futureResolverFuture)),
     func("FutureResolver.new_",     zErrFunc(futureResolverNew)),
 
+    // ListValue
+    func("ListValue.$index",    zErrFunc(ListValue_index)),
+    func("ListValue.$setIndex", zErrFunc(ListValue_setIndex)),
+    func("ListValue.addr_",     ListValue_addr),
+    func("ListValue.append",    zErrFunc(ListValue_append)),
+    func("ListValue.insert",    zErrFunc(ListValue_insert)),
+    func("ListValue.len",       ListValue_len),
+    func("ListValue.remove",    zErrFunc(ListValue_remove)),
+    func("ListValue.new_",      zErrFunc(ListValue_new)),
+
     // DefaultMemory
     func("DefaultMemory.alloc",     zErrFunc(DefaultMemory_alloc)),
     func("DefaultMemory.free",      zErrFunc(DefaultMemory_free)), 
@@ -282,12 +311,15 @@ const vm_types = [_]C.HostTypeEntry{
     htype("Map",            C.CORE_TYPE(bt.Map)),
     htype("MapIterator",    C.CORE_TYPE(bt.MapIter)),
     htype("String",         C.CORE_TYPE(bt.String)),
+    htype("StringBuilder",  C.HOST_OBJECT(null, null, string.stringBuilderFinalizer)),
+    htype("StringSplitIterator", C.HOST_OBJECT(null, string.stringSplitIteratorGetChildren, null)),
     htype("ExternFunc",     C.CORE_TYPE(bt.ExternFunc)),
     htype("Fiber",          C.CORE_TYPE(bt.Fiber)),
     htype("Range",          C.DECL_TYPE(bt.Range)),
     htype("TccState",       C.CORE_TYPE(bt.TccState)),
     htype("Future",         C.HOST_OBJECT(null, futureGetChildren, null)),
     htype("FutureResolver", C.HOST_OBJECT(null, futureResolverGetChildren, null)),
+    htype("ListValue",      C.HOST_OBJECT(null, listValueGetChildren, listValueFinalizer)),
     htype("Memory",         C.DECL_TYPE(bt.Memory)),
     htype("array_t",        C.CREATE_TYPE(createArrayType)),
     htype("FuncSig",        C.DECL_TYPE(bt.FuncSig)), 
@@ -415,6 +447,8 @@ pub const BuiltinsData = struct {
     OptionString: cy.TypeId,
     PtrVoid: cy.TypeId,
     PtrSliceByte: cy.TypeId,
+    StringBuilder: cy.TypeId,
+    StringSplitIterator: cy.TypeId,
 };
 
 pub fn create(vm: *cy.VM, r_uri: []const u8) C.Module {
@@ -489,6 +523,9 @@ fn onLoad(vm_: ?*C.VM, mod: C.Sym) callconv(.C) void {
     defer vm.release(byte_t);
     assert(vm.expandTemplateType(ptr_slice_tmpl, &.{byte_t}, &data.PtrSliceByte));
 
+    data.StringBuilder = chunk_sym.getMod().getSym("StringBuilder").?.getStaticType().?;
+    data.StringSplitIterator = chunk_sym.getMod().getSym("StringSplitIterator").?.getStaticType().?;
+
     // Verify all core types have been initialized.
     if (cy.Trace) {
         if (ivm.sema.types.items[0].kind != .null) {
@@ -550,6 +587,8 @@ fn errorSymbol(err: anyerror) Symbol {
         error.InvalidEnumTag        => return .InvalidArgument,
         error.FileNotFound          => return .FileNotFound,
         error.OutOfBounds           => return .OutOfBounds,
+        error.StringTooLong         => return .OutOfBounds,
+        error.ParseError            => return .ParseError,
         error.PermissionDenied      => return .PermissionDenied,
         error.StdoutStreamTooLong   => return .StreamTooLong,
         error.StderrStreamTooLong   => return .StreamTooLong,
@@ -1147,6 +1186,115 @@ pub fn futureResolverNew(vm: *cy.VM) anyerror!Value {
     return vm.allocFutureResolver(resolver_t, future);
 }
 
+pub fn listValueFinalizer(vm_: ?*C.VM, obj: ?*anyopaque) callconv(.C) void {
+    const vm: *cy.VM = @ptrCast(@alignCast(vm_));
+    var list: *cy.heap.ListValueInner = @ptrCast(@alignCast(obj));
+    list.deinit(vm.alloc);
+}
+
+pub fn listValueGetChildren(_: ?*C.VM, obj: ?*anyopaque) callconv(.C) C.ValueSlice {
+    var list: *cy.heap.ListValueInner = @ptrCast(@alignCast(obj));
+    if (list.elem != .boxed) {
+        return .{ .ptr = null, .len = 0 };
+    }
+    const items = list.slots();
+    return .{
+        .ptr = @ptrCast(items.ptr),
+        .len = items.len,
+    };
+}
+
+/// Copies `val` into an element slot. Boxed values are retained.
+fn listValueWrite(vm: *cy.VM, list: *cy.heap.ListValueInner, dst: [*]Value, val: Value) void {
+    switch (list.elem) {
+        .unboxed => dst[0] = val,
+        .boxed => {
+            vm.retain(val);
+            dst[0] = val;
+        },
+        .struct_t => {
+            const fields = val.castHeapObject(*cy.heap.Object).getValuesPtr();
+            @memcpy(dst[0..list.stride], fields[0..list.stride]);
+        },
+    }
+}
+
+fn ListValue_new(vm: *cy.VM) anyerror!Value {
+    const list_t: cy.TypeId = @intCast(vm.getInt(0));
+    const elem_t: cy.TypeId = @intCast(vm.getInt(1));
+    const type_e = vm.c.types[elem_t];
+    if (type_e.kind == .struct_t) {
+        if (type_e.data.struct_t.has_boxed_fields) {
+            // Inline fields would need to be visited by the cycle collector.
+            return error.Unsupported;
+        }
+        return vm.allocListValue(list_t, .struct_t, type_e.data.struct_t.nfields);
+    } else if (vm.sema.isUnboxedType(elem_t)) {
+        return vm.allocListValue(list_t, .unboxed, 1);
+    } else {
+        return vm.allocListValue(list_t, .boxed, 1);
+    }
+}
+
+fn ListValue_index(vm: *cy.VM) anyerror!Value {
+    const list = vm.getHostObject(*cy.heap.ListValueInner, 0);
+    const idx = try intAsIndex(vm.getInt(1), list.len);
+    return Value.initRaw(@intFromPtr(list.elemPtr(idx)));
+}
+
+fn ListValue_setIndex(vm: *cy.VM) anyerror!Value {
+    const list = vm.getHostObject(*cy.heap.ListValueInner, 0);
+    const idx = try intAsIndex(vm.getInt(1), list.len);
+    const dst = list.elemPtr(idx);
+    if (list.elem == .boxed) {
+        vm.release(dst[0]);
+    }
+    listValueWrite(vm, list, dst, vm.getValue(2));
+    return Value.Void;
+}
+
+fn ListValue_addr(vm: *cy.VM) Value {
+    const list = vm.getHostObject(*cy.heap.ListValueInner, 0);
+    return Value.initInt(@intCast(@intFromPtr(list.ptr)));
+}
+
+fn ListValue_append(vm: *cy.VM) anyerror!Value {
+    const list = vm.getHostObject(*cy.heap.ListValueInner, 0);
+    try list.growTotalCapacity(vm.alloc, list.len + 1);
+    listValueWrite(vm, list, list.elemPtr(list.len), vm.getValue(1));
+    list.len += 1;
+    return Value.Void;
+}
+
+fn ListValue_insert(vm: *cy.VM) anyerror!Value {
+    const list = vm.getHostObject(*cy.heap.ListValueInner, 0);
+    const idx = try intAsIndex(vm.getInt(1), list.len + 1);
+    try list.growTotalCapacity(vm.alloc, list.len + 1);
+    const stride = list.stride;
+    const src = list.ptr[idx * stride..list.len * stride];
+    std.mem.copyBackwards(Value, list.ptr[(idx + 1) * stride..(list.len + 1) * stride], src);
+    listValueWrite(vm, list, list.elemPtr(idx), vm.getValue(2));
+    list.len += 1;
+    return Value.Void;
+}
+
+fn ListValue_len(vm: *cy.VM) Value {
+    const list = vm.getHostObject(*cy.heap.ListValueInner, 0);
+    return Value.initInt(@intCast(list.len));
+}
+
+fn ListValue_remove(vm: *cy.VM) anyerror!Value {
+    const list = vm.getHostObject(*cy.heap.ListValueInner, 0);
+    const idx = try intAsIndex(vm.getInt(1), list.len);
+    if (list.elem == .boxed) {
+        vm.release(list.ptr[idx]);
+    }
+    const stride = list.stride;
+    std.mem.copyForwards(Value, list.ptr[idx * stride..(list.len - 1) * stride], list.ptr[(idx + 1) * stride..list.len * stride]);
+    list.len -= 1;
+    return Value.Void;
+}
+
 pub fn DefaultMemory_alloc(vm: *cy.VM) anyerror!Value {
     if (cy.isWasm) return vm.prepPanic("Unsupported.");
     const size: usize = @intCast(vm.getInt(1));
@@ -247,10 +247,10 @@ fn genNodeValue(vm: *cy.VM, view: ast.AstView, node: *ast.Node) !cy.Value {
         .func_param => {
             const param = node.cast(.func_param);
             const name = view.nodeString(param.name_type);
-            try vm.mapSet(map, try vm.retainOrAllocAstring("name"), try vm.allocString(name));
+            try vm.mapSet(map, try vm.allocInternedString("name"), try vm.allocString(name));
 
             const typeSpec = try genTypeSpecString(vm, view, param.type);
-            try vm.mapSet(map, try vm.retainOrAllocAstring("typeSpec"), typeSpec);
+            try vm.mapSet(map, try vm.allocInternedString("typeSpec"), typeSpec);
         },
         else => {},
     }
@@ -267,24 +267,24 @@ fn genImplicitFuncDeclEntry(vm: *cy.VM, view: ast.AstView, node: *ast.FuncDecl,
         const param_v = try genNodeValue(vm, view, @ptrCast(param));
         try params.asHeapObject().list.append(vm.alloc, param_v);
     }
-    try vm.mapSet(entry, try vm.retainOrAllocAstring("params"), params);
+    try vm.mapSet(entry, try vm.allocInternedString("params"), params);
 
     const ret = try genTypeSpecString(vm, view, node.ret);
-    try vm.mapSet(entry, try vm.retainOrAllocAstring("ret"), ret);
+    try vm.mapSet(entry, try vm.allocInternedString("ret"), ret);
 
     const hidden = cy.Value.initBool(node.hidden);
-    try vm.mapSet(entry, try vm.retainOrAllocAstring("hidden"), hidden);
+    try vm.mapSet(entry, try vm.allocInternedString("hidden"), hidden);
 
     state.pos = node.pos;
     state.node = @ptrCast(node);
 
     // Find doc comments.
     if (try genDocComment(vm, view, .funcDecl, state)) |docStr| {
-        try vm.mapSet(entry, try vm.retainOrAllocAstring("docs"), docStr);
+        try vm.mapSet(entry, try vm.allocInternedString("docs"), docStr);
     }
 
-    try vm.mapSet(entry, try vm.retainOrAllocAstring("name"), try vm.retainOrAllocAstring(name));
-    try vm.mapSet(entry, try vm.retainOrAllocAstring("pos"), try vm.allocInt(@intCast(node.pos)));
+    try vm.mapSet(entry, try vm.allocInternedString("name"), try vm.retainOrAllocAstring(name));
+    try vm.mapSet(entry, try vm.allocInternedString("pos"), try vm.allocInt(@intCast(node.pos)));
     return entryv;
 }
 
@@ -292,13 +292,13 @@ fn genDeclEntry(vm: *cy.VM, view: ast.AstView, decl: *ast.Node, state: *ParseCyb
     const entryv = try vm.allocEmptyMap();
     const entry = entryv.castHeapObject(*cy.heap.Map);
     const name = try view.declNamePath(decl);
-    try vm.mapSet(entry, try vm.retainOrAllocAstring("type"), try vm.retainOrAllocAstring(@tagName(decl.type())));
+    try vm.mapSet(entry, try vm.allocInternedString("type"), try vm.retainOrAllocAstring(@tagName(decl.type())));
 
     switch (decl.type()) {
         .staticDecl => {
             const static_decl = decl.cast(.staticDecl);
             const typeSpec = try genTypeSpecString(vm, view, static_decl.typeSpec);
-            try vm.mapSet(entry, try vm.retainOrAllocAstring("typeSpec"), typeSpec);
+            try vm.mapSet(entry, try vm.allocInternedString("typeSpec"), typeSpec);
         },
         .enumDecl,
         .use_alias,
@@ -307,7 +307,7 @@ fn genDeclEntry(vm: *cy.VM, view: ast.AstView, decl: *ast.Node, state: *ParseCyb
         .template => {
             const template = decl.cast(.template);
             const child = try genDeclEntry(vm, view, template.child_decl, state);
-            try vm.mapSet(entry, try vm.retainOrAllocAstring("child"), child);
+            try vm.mapSet(entry, try vm.allocInternedString("child"), child);
         },
         .funcDecl => {
             const func_decl = decl.cast(.funcDecl);
@@ -317,13 +317,13 @@ fn genDeclEntry(vm: *cy.VM, view: ast.AstView, decl: *ast.Node, state: *ParseCyb
                 const param_v = try genNodeValue(vm, view, @ptrCast(param));
                 try params.asHeapObject().list.append(vm.alloc, param_v);
             }
-            try vm.mapSet(entry, try vm.retainOrAllocAstring("params"), params);
+            try vm.mapSet(entry, try vm.allocInternedString("params"), params);
 
             const hidden = cy.Value.initBool(func_decl.hidden);
-            try vm.mapSet(entry, try vm.retainOrAllocAstring("hidden"), hidden);
+            try vm.mapSet(entry, try vm.allocInternedString("hidden"), hidden);
 
             const ret = try genTypeSpecString(vm, view, func_decl.ret);
-            try vm.mapSet(entry, try vm.retainOrAllocAstring("ret"), ret);
+            try vm.mapSet(entry, try vm.allocInternedString("ret"), ret);
         },
         .structDecl => {
             const struct_decl = decl.cast(.structDecl);
@@ -332,7 +332,7 @@ fn genDeclEntry(vm: *cy.VM, view: ast.AstView, decl: *ast.Node, state: *ParseCyb
                 const f = try genImplicitFuncDeclEntry(vm, view, func_decl, state);
                 try funcs_.asHeapObject().list.append(vm.alloc, f);
             }
-            try vm.mapSet(entry, try vm.retainOrAllocAstring("funcs"), funcs_);
+            try vm.mapSet(entry, try vm.allocInternedString("funcs"), funcs_);
         },
         .objectDecl => {
             const object_decl = decl.cast(.objectDecl);
@@ -341,7 +341,7 @@ fn genDeclEntry(vm: *cy.VM, view: ast.AstView, decl: *ast.Node, state: *ParseCyb
                 const f = try genImplicitFuncDeclEntry(vm, view, func_decl, state);
                 try funcs_.asHeapObject().list.append(vm.alloc, f);
             }
-            try vm.mapSet(entry, try vm.retainOrAllocAstring("funcs"), funcs_);
+            try vm.mapSet(entry, try vm.allocInternedString("funcs"), funcs_);
         },
         .custom_decl => {
             const custom_decl = decl.cast(.custom_decl);
@@ -350,7 +350,7 @@ fn genDeclEntry(vm: *cy.VM, view: ast.AstView, decl: *ast.Node, state: *ParseCyb
                 const f = try genImplicitFuncDeclEntry(vm, view, func_decl, state);
                 try funcs_.asHeapObject().list.append(vm.alloc, f);
             }
-            try vm.mapSet(entry, try vm.retainOrAllocAstring("funcs"), funcs_);
+            try vm.mapSet(entry, try vm.allocInternedString("funcs"), funcs_);
         },
         .distinct_decl => {
             const distinct_decl = decl.cast(.distinct_decl);
@@ -359,7 +359,7 @@ fn genDeclEntry(vm: *cy.VM, view: ast.AstView, decl: *ast.Node, state: *ParseCyb
                 const f = try genImplicitFuncDeclEntry(vm, view, func_decl, state);
                 try funcs_.asHeapObject().list.append(vm.alloc, f);
             }
-            try vm.mapSet(entry, try vm.retainOrAllocAstring("funcs"), funcs_);
+            try vm.mapSet(entry, try vm.allocInternedString("funcs"), funcs_);
         },
         .trait_decl => {
             const trait_decl = decl.cast(.trait_decl);
@@ -368,7 +368,7 @@ fn genDeclEntry(vm: *cy.VM, view: ast.AstView, decl: *ast.Node, state: *ParseCyb
                 const f = try genImplicitFuncDeclEntry(vm, view, func_decl, state);
                 try funcs_.asHeapObject().list.append(vm.alloc, f);
             }
-            try vm.mapSet(entry, try vm.retainOrAllocAstring("funcs"), funcs_);
+            try vm.mapSet(entry, try vm.allocInternedString("funcs"), funcs_);
         },
         else => {
             log.tracev("{}", .{decl.type()});
@@ -380,11 +380,11 @@ fn genDeclEntry(vm: *cy.VM, view: ast.AstView, decl: *ast.Node, state: *ParseCyb
 
     // Find doc comments.
     if (try genDocComment(vm, view, decl.type(), state)) |docStr| {
-        try vm.mapSet(entry, try vm.retainOrAllocAstring("docs"), docStr);
+        try vm.mapSet(entry, try vm.allocInternedString("docs"), docStr);
     }
 
-    try vm.mapSet(entry, try vm.retainOrAllocAstring("name"), try vm.retainOrAllocAstring(name));
-    try vm.mapSet(entry, try vm.retainOrAllocAstring("pos"), try vm.allocInt(@intCast(decl.pos())));
+    try vm.mapSet(entry, try vm.allocInternedString("name"), try vm.retainOrAllocAstring(name));
+    try vm.mapSet(entry, try vm.allocInternedString("pos"), try vm.allocInt(@intCast(decl.pos())));
     return entryv;
 }
 
@@ -490,55 +490,80 @@ fn parseCyberGenResult(vm: *cy.VM, parser: *const cy.Parser) !cy.Value {
 pub fn parseCyon(vm: *cy.VM) anyerror!cy.Value {
     const src = vm.getString(0);
 
-    var parser: cy.Parser = undefined;
-    try parser.init(vm.alloc);
-    defer parser.deinit();
-    const val = try cy.decodeCyon(vm.alloc, &parser, src);
-    return fromCyonValue(vm, val);
+    var decoder = cy.CyonDecoder.init(vm.alloc, src);
+    defer decoder.deinit();
+    var builder = CyonBuilder{ .vm = vm };
+    return decoder.decode(&builder);
 }
 
-fn fromCyonValue(vm: *cy.VM, val: cy.DecodeValueIR) !cy.Value {
-    switch (val.getValueType()) {
-        .list => {
-            var dlist = try val.getList();
-            defer dlist.deinit();
-            const elems = try vm.alloc.alloc(cy.Value, dlist.arr.len);
-            for (elems, 0..) |*elem, i| {
-                elem.* = try fromCyonValue(vm, dlist.getIndex(i));
-            }
-            return try cy.heap.allocOwnedList(vm, elems);
-        },
-        .map => {
-            var dmap = try val.getMap();
-            defer dmap.deinit();
-            var iter = dmap.iterator();
-
-            const mapVal = try vm.allocEmptyMap();
-            const map = mapVal.asHeapObject();
-            while (iter.next()) |entry| {
-                const child = try fromCyonValue(vm, dmap.getValue(entry.key_ptr.*));
-                const key = try vm.allocString(entry.key_ptr.*);
-                try map.map.setConsume(vm, key, child);
-            }
-            return mapVal;
-        },
-        .string => {
-            const str = try val.allocString();
-            defer val.alloc.free(str);
-            // TODO: Use allocOwnedString
-            return try vm.allocString(str);
-        },
-        .integer => {
-            return vm.allocInt(try val.getInt());
-        },
-        .float => {
-            return cy.Value.initF64(try val.getF64());
-        },
-        .bool => {
-            return cy.Value.initBool(val.getBool());
-        },
+/// Builds VM values directly from `cy.CyonDecoder`.
+const CyonBuilder = struct {
+    vm: *cy.VM,
+
+    pub const Value = cy.Value;
+    pub const List = std.ArrayListUnmanaged(cy.Value);
+    pub const Table = cy.Value;
+
+    pub fn newList(_: *CyonBuilder) !List {
+        return .{};
+    }
+
+    pub fn listAppend(self: *CyonBuilder, list: *List, val: cy.Value) !void {
+        errdefer self.vm.release(val);
+        try list.append(self.vm.alloc, val);
     }
-}
+
+    pub fn endList(self: *CyonBuilder, list: *List) !cy.Value {
+        const elems = try list.toOwnedSlice(self.vm.alloc);
+        return cy.heap.allocOwnedList(self.vm, elems);
+    }
+
+    pub fn abortList(self: *CyonBuilder, list: *List) void {
+        for (list.items) |it| {
+            self.vm.release(it);
+        }
+        list.deinit(self.vm.alloc);
+    }
+
+    pub fn newTable(self: *CyonBuilder) !Table {
+        return self.vm.allocEmptyMap();
+    }
+
+    pub fn tableSet(self: *CyonBuilder, table: *Table, key: []const u8, val: cy.Value) !void {
+        errdefer self.vm.release(val);
+        const key_v = try self.vm.allocString(key);
+        errdefer self.vm.release(key_v);
+        try table.asHeapObject().map.setConsume(self.vm, key_v, val);
+    }
+
+    pub fn endTable(_: *CyonBuilder, table: *Table) !cy.Value {
+        return table.*;
+    }
+
+    pub fn abortTable(self: *CyonBuilder, table: *Table) void {
+        self.vm.release(table.*);
+    }
+
+    pub fn string(self: *CyonBuilder, str: []const u8) !cy.Value {
+        return self.vm.allocString(str);
+    }
+
+    pub fn int(self: *CyonBuilder, i: i64) !cy.Value {
+        return self.vm.allocInt(i);
+    }
+
+    pub fn float(_: *CyonBuilder, f: f64) !cy.Value {
+        return cy.Value.initF64(f);
+    }
+
+    pub fn boolean(_: *CyonBuilder, b: bool) !cy.Value {
+        return cy.Value.initBool(b);
+    }
+
+    pub fn release(self: *CyonBuilder, val: cy.Value) void {
+        self.vm.release(val);
+    }
+};
 
 pub fn toCyon(vm: *cy.VM) anyerror!cy.Value {
     const res = try allocToCyon(vm, vm.alloc, vm.getValue(0));
@@ -547,113 +572,65 @@ pub fn toCyon(vm: *cy.VM) anyerror!cy.Value {
 }
 
 pub fn allocToCyon(vm: *cy.VM, alloc: std.mem.Allocator, root: cy.Value) ![]const u8 {
-    const S = struct {
-        fn encodeTable(ctx: *cy.EncodeTableContext, val: cy.Value) anyerror!void {
-            const uservm = cy.ptrAlignCast(*cy.VM, ctx.user_ctx);
-            var iter = val.asHeapObject().table.map().iterator();
-            while (iter.next()) |e| {
-                const key = try uservm.getOrBufPrintValueStr(&cy.tempBuf, e.key);
-                switch (e.value.getTypeId()) {
-                    bt.Float => {
-                        try ctx.encodeFloat(key, e.value.asF64());
-                    },
-                    bt.Integer => {
-                        try ctx.encodeInt(key, e.value.asBoxInt());
-                    },
-                    bt.String => {
-                        const keyDupe = try uservm.alloc.dupe(u8, key);
-                        defer uservm.alloc.free(keyDupe);
-                        const str = try uservm.getOrBufPrintValueStr(&cy.tempBuf, e.value);
-                        try ctx.encodeString(keyDupe, str);
-                    },
-                    bt.Boolean => {
-                        try ctx.encodeBool(key, e.value.asBool());
-                    },
-                    bt.Table => {
-                        try ctx.encodeTable(key, e.value, encodeTable);
-                    },
-                    bt.ListDyn => {
-                        try ctx.encodeList(key, e.value, encodeList);
-                    },
-                    else => {},
-                }
-            }
-        }
-        fn encodeList(ctx: *cy.EncodeListContext, val: cy.Value) anyerror!void {
-            const items = val.asHeapObject().list.items();
-            for (items) |it| {
-                try ctx.indent();
-                switch (it.getTypeId()) {
-                    bt.Float => {
-                        try ctx.encodeFloat(it.asF64());
-                        _ = try ctx.writer.write(",\n");
-                    },
-                    bt.Integer => {
-                        try ctx.encodeInt(it.asBoxInt());
-                        _ = try ctx.writer.write(",\n");
-                    },
-                    bt.String => {
-                        const uservm = cy.ptrAlignCast(*cy.VM, ctx.user_ctx);
-                        const str = try uservm.getOrBufPrintValueStr(&cy.tempBuf, it);
-                        try ctx.encodeString(str);
-                        _ = try ctx.writer.write(",\n");
-                    },
-                    bt.Boolean => {
-                        try ctx.encodeBool(it.asBool());
-                        _ = try ctx.writer.write(",\n");
-                    },
-                    bt.Table => {
-                        try ctx.encodeTable(it, encodeTable);
-                        _ = try ctx.writer.write(",\n");
-                    },
-                    bt.ListDyn => {
-                        try ctx.encodeList(it, encodeList);
-                        _ = try ctx.writer.write(",\n");
-                    },
-                    else => {},
-                }
+    var buf: std.ArrayListUnmanaged(u8) = .{};
+    errdefer buf.deinit(alloc);
+    var enc = cy.CyonStreamEncoder(std.ArrayListUnmanaged(u8).Writer).init(buf.writer(alloc));
+    try encodeCyonValue(vm, &enc, root);
+    return buf.toOwnedSlice(alloc);
+}
+
+fn isCyonType(type_id: cy.TypeId) bool {
+    return switch (type_id) {
+        bt.Float,
+        bt.Integer,
+        bt.String,
+        bt.Boolean,
+        bt.ListDyn,
+        bt.Table,
+        bt.Map => true,
+        else => false,
+    };
+}
+
+/// Writes `val` to a `cy.CyonStreamEncoder`. Values without a CYON representation are skipped.
+pub fn encodeCyonValue(vm: *cy.VM, enc: anytype, val: cy.Value) anyerror!void {
+    switch (val.getTypeId()) {
+        bt.Float => {
+            try enc.float(val.asF64());
+        },
+        bt.Integer => {
+            try enc.int(val.asBoxInt());
+        },
+        bt.String => {
+            try enc.string(val.asString());
+        },
+        bt.Boolean => {
+            try enc.boolean(val.asBool());
+        },
+        bt.ListDyn => {
+            try enc.beginList();
+            for (val.asHeapObject().list.items()) |it| {
+                try encodeCyonValue(vm, enc, it);
             }
-        }
-        fn encodeRoot(ctx: *cy.EncodeValueContext, val: anytype) !void {
-            const T = @TypeOf(val);
-            if (T == cy.Value) {
-                switch (val.getTypeId()) {
-                    bt.Float => {
-                        try ctx.encodeFloat(val.asF64());
-                    },
-                    bt.Integer => {
-                        try ctx.encodeInt(val.asBoxInt());
-                    },
-                    bt.String => {
-                        const uservm = cy.ptrAlignCast(*cy.VM, ctx.user_ctx);
-                        const str = try uservm.getOrBufPrintValueStr(&cy.tempBuf, val);
-                        try ctx.encodeString(str);
-                    },
-                    bt.Boolean => {
-                        try ctx.encodeBool(val.asBool());
-                    },
-                    bt.ListDyn => {
-                        if (val.asHeapObject().list.items().len == 0) {
-                            _ = try ctx.writer.write("{_}");
-                        } else {
-                            try ctx.encodeList(val, encodeList);
-                        }
-                    },
-                    bt.Table => {
-                        if (val.asHeapObject().table.map().size == 0) {
-                            _ = try ctx.writer.write("{}");
-                        } else {
-                            try ctx.encodeTable(val, encodeTable);
-                        }
-                    },
-                    else => {},
+            try enc.endList();
+        },
+        bt.Table,
+        bt.Map => {
+            const map = if (val.getTypeId() == bt.Table) val.asHeapObject().table.map() else val.asHeapObject().map.map();
+            try enc.beginTable();
+            var iter = map.iterator();
+            while (iter.next()) |e| {
+                if (!isCyonType(e.value.getTypeId())) {
+                    continue;
                 }
-            } else {
-                cy.panicFmt("unsupported: {s}", .{@typeName(T)});
+                const key = try vm.getOrBufPrintValueStr(&cy.tempBuf, e.key);
+                try enc.key(key);
+                try encodeCyonValue(vm, enc, e.value);
             }
-        }
-    };
-    return try cy.encodeCyon(alloc, vm, root, S.encodeRoot);
+            try enc.endTable();
+        },
+        else => {},
+    }
 }
 
 pub const IReplReadLine = struct {
@@ -0,0 +1,684 @@
+const std = @import("std");
+const stdx = @import("stdx");
+const t = stdx.testing;
+const cy = @import("../cyber.zig");
+const C = @import("../capi.zig");
+const Value = cy.Value;
+const bt = cy.types.BuiltinTypes;
+const log = cy.log.scoped(.json);
+
+const Src = @embedFile("json.cy");
+const zErrFunc = cy.builtins.zErrFunc;
+
+pub fn create(vm: *cy.VM, r_uri: []const u8) C.Module {
+    const core_data = vm.getData(*cy.builtins.CoreData, "core");
+    const mod = C.createModule(@ptrCast(vm), C.toStr(r_uri), C.toStr(Src));
+
+    const htype = C.hostTypeEntry;
+    const types = [_]C.HostTypeEntry{
+        htype("Doc", C.HOST_OBJECT(&core_data.JsonDocT, docGetChildren, docFinalizer)),
+    };
+
+    var config = C.ModuleConfig{
+        .funcs = C.toSlice(C.HostFuncEntry, &funcs),
+        .types = C.toSlice(C.HostTypeEntry, &types),
+    };
+    C.setModuleConfig(@ptrCast(vm), mod, &config);
+    return mod;
+}
+
+const func = cy.hostFuncEntry;
+const funcs = [_]C.HostFuncEntry{
+    func("parse",     zErrFunc(parse)),
+    func("parseLazy", zErrFunc(parseLazy)),
+    func("stringify", zErrFunc(stringify)),
+
+    func("Doc.get",   zErrFunc(Doc_get)),
+};
+
+const Vec = @Vector(64, u8);
+
+inline fn eqMask(v: Vec, ch: u8) u64 {
+    return @bitCast(v == @as(Vec, @splat(ch)));
+}
+
+/// Each bit becomes the xor of itself and all lower bits.
+inline fn prefixXor(bits: u64) u64 {
+    var x = bits;
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/// Returns the mask of characters escaped by an odd run of backslashes.
+/// `prev_escaped` carries whether the first character of the next block is escaped.
+inline fn findEscaped(backslash_: u64, prev_escaped: *u64) u64 {
+    const even_bits: u64 = 0x5555555555555555;
+    const backslash = backslash_ & ~prev_escaped.*;
+    const follows_escape = (backslash << 1) | prev_escaped.*;
+    const odd_starts = backslash & ~even_bits & ~follows_escape;
+    const res = @addWithOverflow(odd_starts, backslash);
+    prev_escaped.* = res[1];
+    const invert_mask = res[0] << 1;
+    return (even_bits ^ invert_mask) & follows_escape;
+}
+
+/// Stage 1: Appends the offsets of every structural character (`{}[]:,` outside of strings)
+/// and every unescaped quote to `out`. The source is classified 64 bytes at a time.
+pub fn indexStructurals(alloc: std.mem.Allocator, src: []const u8, out: *std.ArrayListUnmanaged(u32)) !void {
+    if (src.len > std.math.maxInt(u32)) {
+        return error.InvalidArgument;
+    }
+    var prev_escaped: u64 = 0;
+    var prev_in_string: u64 = 0;
+    var pad: [64]u8 = undefined;
+    var i: usize = 0;
+    while (i < src.len) : (i += 64) {
+        const block: *const [64]u8 = if (i + 64 <= src.len) src[i..][0..64] else b: {
+            @memset(&pad, ' ');
+            @memcpy(pad[0..src.len-i], src[i..]);
+            break :b &pad;
+        };
+        const v: Vec = block.*;
+
+        const escaped = findEscaped(eqMask(v, '\\'), &prev_escaped);
+        const quotes = eqMask(v, '"') & ~escaped;
+        const in_string = prefixXor(quotes) ^ prev_in_string;
+        prev_in_string = @bitCast(@as(i64, @bitCast(in_string)) >> 63);
+
+        const ops = eqMask(v, '{') | eqMask(v, '}') | eqMask(v, '[') | eqMask(v, ']') | eqMask(v, ':') | eqMask(v, ',');
+        var bits = (ops & ~in_string) | quotes;
+
+        try out.ensureUnusedCapacity(alloc, @popCount(bits));
+        while (bits != 0) {
+            out.appendAssumeCapacity(@intCast(i + @ctz(bits)));
+            bits &= bits - 1;
+        }
+    }
+    if (prev_in_string != 0) {
+        return error.UnterminatedString;
+    }
+}
+
+/// Keys longer than this aren't cached.
+const MaxCachedKeyLen = 64;
+const MaxCachedKeys = 1024;
+
+/// Arrays and objects nested deeper than this are a parse error.
+const MaxDepth = 1024;
+
+/// Stage 2: Builds VM values by walking the structural index. Scalars are found
+/// between structurals, so only whitespace skipping touches bytes outside the index.
+const Parser = struct {
+    vm: *cy.VM,
+    src: []const u8,
+    idx: []const u32,
+
+    /// Next structural in `idx`.
+    pos: usize,
+
+    /// Source offset after the last consumed token.
+    cur: usize,
+
+    /// Object keys seen so far mapped to a retained string. Payloads tend to repeat
+    /// the same keys so this saves an allocation per key.
+    keys: std.StringHashMapUnmanaged(Value),
+
+    /// Shared stack for array elements of all nesting levels.
+    stack: std.ArrayListUnmanaged(Value),
+
+    /// Scratch space for unescaped strings.
+    buf: std.ArrayListUnmanaged(u8),
+
+    /// Number of enclosing arrays and objects of the value being parsed.
+    depth: u32,
+
+    fn init(vm: *cy.VM, src: []const u8, idx: []const u32) Parser {
+        return .{
+            .vm = vm,
+            .src = src,
+            .idx = idx,
+            .pos = 0,
+            .cur = 0,
+            .keys = .{},
+            .stack = .{},
+            .buf = .{},
+            .depth = 0,
+        };
+    }
+
+    fn deinit(self: *Parser) void {
+        var iter = self.keys.valueIterator();
+        while (iter.next()) |key| {
+            self.vm.release(key.*);
+        }
+        self.keys.deinit(self.vm.alloc);
+        for (self.stack.items) |val| {
+            self.vm.release(val);
+        }
+        self.stack.deinit(self.vm.alloc);
+        self.buf.deinit(self.vm.alloc);
+    }
+
+    fn skipSpace(self: *Parser) usize {
+        var p = self.cur;
+        while (p < self.src.len) : (p += 1) {
+            switch (self.src[p]) {
+                ' ', '\t', '\r', '\n' => {},
+                else => break,
+            }
+        }
+        return p;
+    }
+
+    /// Returns the next non-whitespace character or 0 at the end.
+    fn peek(self: *Parser) u8 {
+        const p = self.skipSpace();
+        return if (p < self.src.len) self.src[p] else 0;
+    }
+
+    fn expect(self: *Parser, ch: u8) !void {
+        const p = self.skipSpace();
+        if (p >= self.src.len or self.src[p] != ch) {
+            return error.ParseError;
+        }
+        if (self.pos >= self.idx.len or self.idx[self.pos] != p) {
+            return error.ParseError;
+        }
+        self.pos += 1;
+        self.cur = p + 1;
+    }
+
+    /// Returns the raw contents of the next string.
+    fn nextRawString(self: *Parser) ![]const u8 {
+        const p = self.skipSpace();
+        if (p >= self.src.len or self.src[p] != '"') {
+            return error.ParseError;
+        }
+        if (self.pos + 1 >= self.idx.len or self.idx[self.pos] != p) {
+            return error.ParseError;
+        }
+        const end = self.idx[self.pos+1];
+        self.pos += 2;
+        self.cur = end + 1;
+        return self.src[p+1..end];
+    }
+
+    fn unescape(self: *Parser, raw: []const u8) ![]const u8 {
+        if (std.mem.indexOfScalar(u8, raw, '\\') == null) {
+            return raw;
+        }
+        self.buf.clearRetainingCapacity();
+        try self.buf.ensureTotalCapacity(self.vm.alloc, raw.len);
+        var i: usize = 0;
+        while (i < raw.len) {
+            const ch = raw[i];
+            if (ch != '\\') {
+                self.buf.appendAssumeCapacity(ch);
+                i += 1;
+                continue;
+            }
+            if (i + 1 >= raw.len) return error.ParseError;
+            const esc = raw[i+1];
+            i += 2;
+            switch (esc) {
+                '"', '\\', '/' => self.buf.appendAssumeCapacity(esc),
+                'b' => self.buf.appendAssumeCapacity(0x08),
+                'f' => self.buf.appendAssumeCapacity(0x0c),
+                'n' => self.buf.appendAssumeCapacity('\n'),
+                'r' => self.buf.appendAssumeCapacity('\r'),
+                't' => self.buf.appendAssumeCapacity('\t'),
+                'u' => {
+                    if (i + 4 > raw.len) return error.ParseError;
+                    var cp: u21 = try std.fmt.parseInt(u16, raw[i..i+4], 16);
+                    i += 4;
+                    if (cp >= 0xd800 and cp < 0xdc00) {
+                        // Surrogate pair.
+                        if (i + 6 > raw.len or raw[i] != '\\' or raw[i+1] != 'u') return error.ParseError;
+                        const lo = try std.fmt.parseInt(u16, raw[i+2..i+6], 16);
+                        if (lo < 0xdc00 or lo > 0xdfff) return error.ParseError;
+                        cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                        i += 6;
+                    }
+                    // Escapes are at least 6 bytes which covers the largest UTF-8 encoding.
+                    var utf8: [4]u8 = undefined;
+                    const n = try std.unicode.utf8Encode(cp, &utf8);
+                    self.buf.appendSliceAssumeCapacity(utf8[0..n]);
+                },
+                else => return error.ParseError,
+            }
+        }
+        return self.buf.items;
+    }
+
+    fn nextKey(self: *Parser) !Value {
+        const raw = try self.nextRawString();
+        if (self.keys.get(raw)) |key| {
+            self.vm.retain(key);
+            return key;
+        }
+        const key = try self.vm.allocString(try self.unescape(raw));
+        if (raw.len <= MaxCachedKeyLen and self.keys.count() < MaxCachedKeys) {
+            try self.keys.put(self.vm.alloc, raw, key);
+            self.vm.retain(key);
+        }
+        return key;
+    }
+
+    fn parseValue(self: *Parser) anyerror!Value {
+        switch (self.peek()) {
+            '{' => {
+                try self.enter();
+                defer self.depth -= 1;
+                try self.expect('{');
+                return self.parseObject();
+            },
+            '[' => {
+                try self.enter();
+                defer self.depth -= 1;
+                try self.expect('[');
+                return self.parseArray();
+            },
+            '"' => {
+                const raw = try self.nextRawString();
+                return self.vm.allocString(try self.unescape(raw));
+            },
+            0 => return error.ParseError,
+            else => return self.parseScalar(),
+        }
+    }
+
+    /// Parsing recurses per nesting level, so deep input is rejected before it can
+    /// overflow the native stack.
+    fn enter(self: *Parser) !void {
+        if (self.depth == MaxDepth) {
+            return error.ParseError;
+        }
+        self.depth += 1;
+    }
+
+    fn parseObject(self: *Parser) !Value {
+        const map_v = try self.vm.allocEmptyMap();
+        errdefer self.vm.release(map_v);
+        const map = map_v.asHeapObject();
+        if (self.peek() == '}') {
+            try self.expect('}');
+            return map_v;
+        }
+        while (true) {
+            {
+                const key = try self.nextKey();
+                errdefer self.vm.release(key);
+                try self.expect(':');
+                const val = try self.parseValue();
+                errdefer self.vm.release(val);
+                try map.map.setConsume(self.vm, key, val);
+            }
+
+            if (self.peek() == ',') {
+                try self.expect(',');
+            } else {
+                try self.expect('}');
+                return map_v;
+            }
+        }
+    }
+
+    fn parseArray(self: *Parser) !Value {
+        const start = self.stack.items.len;
+        if (self.peek() == ']') {
+            try self.expect(']');
+            return self.vm.allocListDyn(&.{});
+        }
+        while (true) {
+            const val = try self.parseValue();
+            self.stack.append(self.vm.alloc, val) catch |err| {
+                self.vm.release(val);
+                return err;
+            };
+            if (self.peek() == ',') {
+                try self.expect(',');
+            } else {
+                try self.expect(']');
+                break;
+            }
+        }
+        const list = try self.vm.allocListDyn(self.stack.items[start..]);
+        self.stack.items.len = start;
+        return list;
+    }
+
+    /// Scalars end at the next structural or the end of the source.
+    fn parseScalar(self: *Parser) !Value {
+        const p = self.skipSpace();
+        const end = if (self.pos < self.idx.len) self.idx[self.pos] else self.src.len;
+        const token = std.mem.trimRight(u8, self.src[p..end], " \t\r\n");
+        self.cur = p + token.len;
+        if (std.mem.eql(u8, token, "true")) {
+            return Value.True;
+        } else if (std.mem.eql(u8, token, "false")) {
+            return Value.False;
+        } else if (std.mem.eql(u8, token, "null")) {
+            return cy.builtins.anyNone(self.vm);
+        }
+        return self.parseNumber(token);
+    }
+
+    fn parseNumber(self: *Parser, token: []const u8) !Value {
+        if (token.len == 0) {
+            return error.ParseError;
+        }
+        var is_float = false;
+        for (token, 0..) |ch, i| {
+            switch (ch) {
+                '0'...'9' => {},
+                '-' => {
+                    if (i != 0 and token[i-1] != 'e' and token[i-1] != 'E') return error.ParseError;
+                },
+                '+' => {
+                    if (i == 0 or (token[i-1] != 'e' and token[i-1] != 'E')) return error.ParseError;
+                },
+                '.', 'e', 'E' => is_float = true,
+                else => return error.ParseError,
+            }
+        }
+        if (!is_float) {
+            if (std.fmt.parseInt(i64, token, 10)) |i| {
+                return self.vm.allocInt(i);
+            } else |err| {
+                if (err != error.Overflow) return err;
+            }
+        }
+        return Value.initF64(try std.fmt.parseFloat(f64, token));
+    }
+
+    /// Skips over the next value without decoding it.
+    fn skipValue(self: *Parser) !void {
+        switch (self.peek()) {
+            '{', '[' => {
+                var depth: u32 = 0;
+                while (self.pos < self.idx.len) {
+                    const p = self.idx[self.pos];
+                    self.pos += 1;
+                    switch (self.src[p]) {
+                        '{', '[' => depth += 1,
+                        '}', ']' => {
+                            depth -= 1;
+                            if (depth == 0) {
+                                self.cur = p + 1;
+                                return;
+                            }
+                        },
+                        else => {},
+                    }
+                }
+                return error.ParseError;
+            },
+            '"' => {
+                _ = try self.nextRawString();
+            },
+            0 => return error.ParseError,
+            else => {
+                self.cur = if (self.pos < self.idx.len) self.idx[self.pos] else self.src.len;
+            },
+        }
+    }
+
+    /// Moves to the value at `path` and returns whether it exists.
+    fn seek(self: *Parser, path: []const u8) !bool {
+        if (path.len == 0) {
+            return true;
+        }
+        var segs = std.mem.splitScalar(u8, path, '.');
+        while (segs.next()) |seg| {
+            switch (self.peek()) {
+                '{' => {
+                    try self.expect('{');
+                    if (self.peek() == '}') {
+                        return false;
+                    }
+                    while (true) {
+                        const key = try self.unescape(try self.nextRawString());
+                        const found = std.mem.eql(u8, key, seg);
+                        try self.expect(':');
+                        if (found) {
+                            break;
+                        }
+                        try self.skipValue();
+                        if (self.peek() != ',') {
+                            return false;
+                        }
+                        try self.expect(',');
+                    }
+                },
+                '[' => {
+                    const n = std.fmt.parseInt(u32, seg, 10) catch return false;
+                    try self.expect('[');
+                    if (self.peek() == ']') {
+                        return false;
+                    }
+                    var i: u32 = 0;
+                    while (i < n) : (i += 1) {
+                        try self.skipValue();
+                        if (self.peek() != ',') {
+                            return false;
+                        }
+                        try self.expect(',');
+                    }
+                },
+                else => return false,
+            }
+        }
+        return true;
+    }
+};
+
+/// Reports malformed input as `error.ParseError`.
+fn toParseError(err: anyerror) anyerror {
+    return switch (err) {
+        error.OutOfMemory => err,
+        else => error.ParseError,
+    };
+}
+
+pub fn parse(vm: *cy.VM) anyerror!Value {
+    const src = vm.getString(0);
+
+    var idx: std.ArrayListUnmanaged(u32) = .{};
+    defer idx.deinit(vm.alloc);
+    indexStructurals(vm.alloc, src, &idx) catch |err| return toParseError(err);
+
+    var parser = Parser.init(vm, src, idx.items);
+    defer parser.deinit();
+    const res = parser.parseValue() catch |err| return toParseError(err);
+    if (parser.skipSpace() != src.len or parser.pos != idx.items.len) {
+        vm.release(res);
+        return error.ParseError;
+    }
+    return res;
+}
+
+/// Source and structural index of a lazily parsed document.
+pub const Doc = extern struct {
+    src: Value,
+    idx_ptr: [*]u32,
+    idx_len: usize,
+
+    fn index(self: *Doc) []u32 {
+        return self.idx_ptr[0..self.idx_len];
+    }
+};
+
+pub fn parseLazy(vm: *cy.VM) anyerror!Value {
+    const core_data = vm.getData(*cy.builtins.CoreData, "core");
+    const src_v = vm.getValue(0);
+    const src = vm.getString(0);
+
+    var idx: std.ArrayListUnmanaged(u32) = .{};
+    errdefer idx.deinit(vm.alloc);
+    indexStructurals(vm.alloc, src, &idx) catch |err| return toParseError(err);
+    const idx_s = try idx.toOwnedSlice(vm.alloc);
+    errdefer vm.alloc.free(idx_s);
+
+    const doc: *Doc = @ptrCast(@alignCast(try cy.heap.allocHostNoCycObject(vm, core_data.JsonDocT, @sizeOf(Doc))));
+    vm.retain(src_v);
+    doc.* = .{
+        .src = src_v,
+        .idx_ptr = idx_s.ptr,
+        .idx_len = idx_s.len,
+    };
+    return Value.initHostNoCycPtr(doc);
+}
+
+fn Doc_get(vm: *cy.VM) anyerror!Value {
+    const doc = vm.getHostObject(*Doc, 0);
+    const path = vm.getString(1);
+
+    var parser = Parser.init(vm, doc.src.asString(), doc.index());
+    defer parser.deinit();
+    const found = parser.seek(path) catch |err| return toParseError(err);
+    if (!found) {
+        return cy.builtins.anyNone(vm);
+    }
+    return parser.parseValue() catch |err| return toParseError(err);
+}
+
+fn docGetChildren(_: ?*C.VM, obj: ?*anyopaque) callconv(.C) C.ValueSlice {
+    const doc: *Doc = @ptrCast(@alignCast(obj));
+    return .{
+        .ptr = @ptrCast(&doc.src),
+        .len = 1,
+    };
+}
+
+fn docFinalizer(vm_: ?*C.VM, obj: ?*anyopaque) callconv(.C) void {
+    const vm: *cy.VM = @ptrCast(@alignCast(vm_));
+    const doc: *Doc = @ptrCast(@alignCast(obj));
+    vm.alloc.free(doc.index());
+}
+
+pub fn stringify(vm: *cy.VM) anyerror!Value {
+    var buf: std.ArrayListUnmanaged(u8) = .{};
+    defer buf.deinit(vm.alloc);
+    try encodeValue(vm, buf.writer(vm.alloc), vm.getValue(0));
+    return vm.allocString(buf.items);
+}
+
+fn encodeString(w: anytype, str: []const u8) !void {
+    try w.writeByte('"');
+    var start: usize = 0;
+    for (str, 0..) |ch, i| {
+        var esc_buf: [6]u8 = undefined;
+        const esc: []const u8 = switch (ch) {
+            '"' => "\\\"",
+            '\\' => "\\\\",
+            '\n' => "\\n",
+            '\r' => "\\r",
+            '\t' => "\\t",
+            0...0x08, 0x0b, 0x0c, 0x0e...0x1f => std.fmt.bufPrint(&esc_buf, "\\u{x:0>4}", .{ch}) catch unreachable,
+            else => continue,
+        };
+        try w.writeAll(str[start..i]);
+        try w.writeAll(esc);
+        start = i + 1;
+    }
+    try w.writeAll(str[start..]);
+    try w.writeByte('"');
+}
+
+pub fn encodeValue(vm: *cy.VM, w: anytype, val: Value) anyerror!void {
+    const type_id = val.getTypeId();
+    switch (type_id) {
+        bt.Float => {
+            const f = val.asF64();
+            if (!std.math.isFinite(f)) {
+                try w.writeAll("null");
+            } else if (Value.floatCanBeInteger(f)) {
+                try w.print("{d:.0}.0", .{f});
+            } else {
+                try w.print("{d}", .{f});
+            }
+        },
+        bt.Integer => {
+            try w.print("{}", .{val.asBoxInt()});
+        },
+        bt.String => {
+            try encodeString(w, val.asString());
+        },
+        bt.Boolean => {
+            try w.writeAll(if (val.asBool()) "true" else "false");
+        },
+        bt.Void => {
+            try w.writeAll("null");
+        },
+        bt.ListDyn => {
+            try w.writeByte('[');
+            for (val.asHeapObject().list.items(), 0..) |it, i| {
+                if (i > 0) try w.writeByte(',');
+                try encodeValue(vm, w, it);
+            }
+            try w.writeByte(']');
+        },
+        bt.Table,
+        bt.Map => {
+            const map = if (type_id == bt.Table) val.asHeapObject().table.map() else val.asHeapObject().map.map();
+            try w.writeByte('{');
+            var iter = map.iterator();
+            var first = true;
+            while (iter.next()) |e| {
+                if (!first) try w.writeByte(',');
+                first = false;
+                if (e.key.isString()) {
+                    try encodeString(w, e.key.asString());
+                } else {
+                    try encodeString(w, try vm.getOrBufPrintValueStr(&cy.tempBuf, e.key));
+                }
+                try w.writeByte(':');
+                try encodeValue(vm, w, e.value);
+            }
+            try w.writeByte('}');
+        },
+        else => {
+            if (vm.c.types[type_id].kind == .option) {
+                const opt = val.castHeapObject(*cy.heap.Object);
+                if (opt.getValue(0).asInt() == 0) {
+                    try w.writeAll("null");
+                } else {
+                    try encodeValue(vm, w, opt.getValue(1));
+                }
+                return;
+            }
+            log.tracev("unsupported: {}", .{type_id});
+            return error.InvalidArgument;
+        },
+    }
+}
+
+test "json stage 1" {
+    var idx: std.ArrayListUnmanaged(u32) = .{};
+    defer idx.deinit(t.alloc);
+
+    const src =
+        \\{"a": [1, "x,y"], "b\"": "\\", "c": {}}
+    ;
+    try indexStructurals(t.alloc, src, &idx);
+    var chars: std.ArrayListUnmanaged(u8) = .{};
+    defer chars.deinit(t.alloc);
+    for (idx.items) |p| {
+        try chars.append(t.alloc, src[p]);
+    }
+    try t.eqStr(chars.items, "{\"\":[,\"\"],\"\":\"\",\"\":{}}");
+
+    // Escapes that straddle a block boundary.
+    idx.clearRetainingCapacity();
+    const long = "\"" ++ ("a" ** 61) ++ "\\\\\"" ++ ",";
+    try indexStructurals(t.alloc, long, &idx);
+    try t.eqSlice(u32, idx.items, &.{ 0, 64, 65 });
+
+    idx.clearRetainingCapacity();
+    try t.expectError(indexStructurals(t.alloc, "\"abc", &idx), error.UnterminatedString);
+}
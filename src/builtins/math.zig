@@ -4,15 +4,25 @@ const C = @import("../capi.zig");
 const vmc = cy.vmc;
 const Value = cy.Value;
 const bt = cy.types.BuiltinTypes;
+const typed_array = @import("typed_array.zig");
 
 const Src = @embedFile("math.cy");
 
 pub fn create(vm: *cy.VM, r_uri: []const u8) C.Module {
+    const core_data = vm.getData(*cy.builtins.CoreData, "core");
     const mod = C.createModule(@ptrCast(vm), C.toStr(r_uri), C.toStr(Src));
+
+    const htype = C.hostTypeEntry;
+    const types = [_]C.HostTypeEntry{
+        htype("Float32Array", C.HOST_OBJECT(&core_data.Float32ArrayT, null, null)),
+        htype("Float64Array", C.HOST_OBJECT(&core_data.Float64ArrayT, null, null)),
+        htype("Int64Array",   C.HOST_OBJECT(&core_data.Int64ArrayT, null, null)),
+    };
+
     var config = C.ModuleConfig{
         .funcs = C.toSlice(C.HostFuncEntry, &funcs),
         .varLoader = varLoader,
-        .types = C.toSlice(C.HostTypeEntry, &.{}),
+        .types = C.toSlice(C.HostTypeEntry, &types),
     };
     C.setModuleConfig(@ptrCast(vm), mod, &config);
     return mod;
@@ -85,7 +95,7 @@ const funcs = [_]C.HostFuncEntry{
     func("tan",    tan),
     func("tanh",   tanh),
     func("trunc",  trunc),
-};
+} ++ typed_array.funcs;
 
 /// Returns the absolute value of x.
 pub fn abs(vm: *cy.VM) Value {
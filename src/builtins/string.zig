@@ -1,12 +1,13 @@
 const std = @import("std");
 const cy = @import("../cyber.zig");
+const C = @import("../capi.zig");
 const rt = cy.rt;
 const Value = cy.Value;
 const fatal = cy.fatal;
 const bindings = @import("bindings.zig");
 const string = cy.string;
 
-pub fn concat(vm: *cy.VM) Value {
+pub fn concat(vm: *cy.VM) anyerror!Value {
     const obj = vm.getObject(*cy.heap.String, 0);
     const stype = obj.getType();
     const str = obj.getSlice();
@@ -14,17 +15,23 @@ pub fn concat(vm: *cy.VM) Value {
         const obj2 = vm.getObject(*cy.heap.String, 1);
         const rstr = obj2.getSlice();
         if (obj2.getType().isAstring()) {
-            return vm.allocAstringConcat(str, rstr) catch fatal();
+            return vm.allocAstringConcat(str, rstr);
         } else {
-            return vm.allocUstringConcat(str, rstr) catch fatal();
+            return vm.allocUstringConcat(str, rstr);
         }
     } else {
         const obj2 = vm.getObject(*cy.heap.String, 1);
         const rstr = obj2.getSlice();
-        return vm.allocUstringConcat(str, rstr) catch fatal();
+        return vm.allocUstringConcat(str, rstr);
     }
 }
 
+pub fn appendInPlace(vm: *cy.VM) anyerror!Value {
+    const obj = vm.getObject(*cy.heap.String, 0);
+    const obj2 = vm.getObject(*cy.heap.String, 1);
+    return cy.heap.appendStringInPlace(vm, obj, obj2.getSlice(), obj2.getType().isAstring());
+}
+
 pub fn sliceFn(vm: *cy.VM) Value {
     const obj = vm.getObject(*cy.heap.String, 0);
     const stype = obj.getType();
@@ -57,6 +64,11 @@ pub fn sliceFn(vm: *cy.VM) Value {
     }
 }
 
+pub fn intern(vm: *cy.VM) Value {
+    const obj = vm.getObject(*cy.heap.String, 0);
+    return cy.heap.retainOrInternString(vm, obj) catch fatal();
+}
+
 pub fn insertByte(vm: *cy.VM) anyerror!Value {
     const str = vm.getObject(*cy.heap.String, 0);
     const slice = str.getSlice();
@@ -86,13 +98,13 @@ pub fn insertFn(vm: *cy.VM) anyerror!Value {
         const obj2 = vm.getObject(*cy.heap.String, 2);
         const insert = obj2.getSlice();
         if (obj2.getType().isAstring()) {
-            return vm.allocAstringConcat3(str[0..uidx], insert, str[uidx..]) catch fatal();
+            return vm.allocAstringConcat3(str[0..uidx], insert, str[uidx..]);
         } else {
-            return vm.allocUstringConcat3(str[0..uidx], insert, str[uidx..]) catch fatal();
+            return vm.allocUstringConcat3(str[0..uidx], insert, str[uidx..]);
         }
     } else {
         const insert = vm.getString(2);
-        return vm.allocUstringConcat3(str[0..uidx], insert, str[uidx..]) catch fatal();
+        return vm.allocUstringConcat3(str[0..uidx], insert, str[uidx..]);
     }
 }
 
@@ -299,9 +311,31 @@ pub fn seek(vm: *cy.VM) anyerror!Value {
         }
         return Value.initInt(@intCast(idx));
     } else {
+        if (idx < 0) {
+            return error.OutOfBounds;
+        }
         const uidx: u32 = @intCast(idx);
         var bad_byte: bool = undefined;
-        const start: u32 = @intCast(try string.ustringSeekByRuneIndex(str, 0, 0, uidx, &bad_byte));
+        if (str.len >= string.RuneIndexMinByteLen) {
+            const res = try vm.ustrRuneIndexes.getOrPut(vm.alloc, @ptrCast(obj));
+            if (!res.found_existing) {
+                res.value_ptr.* = string.RuneIndex.init(vm.alloc, str) catch |err| {
+                    vm.ustrRuneIndexes.removeByPtr(res.key_ptr);
+                    return err;
+                };
+            }
+            const start = try res.value_ptr.seek(str, uidx, &bad_byte);
+            return Value.initInt(@intCast(start));
+        }
+
+        // Resume from the last seek on the same string.
+        const cursor = &vm.ustrRuneCursor;
+        if (cursor.obj != @as(*anyopaque, @ptrCast(obj))) {
+            cursor.* = .{ .obj = @ptrCast(obj), .byte_idx = 0, .rune_idx = 0 };
+        }
+        const start: u32 = @intCast(try string.ustringSeekByRuneIndex(str, cursor.byte_idx, cursor.rune_idx, uidx, &bad_byte));
+        cursor.byte_idx = start;
+        cursor.rune_idx = uidx;
         return Value.initInt(@intCast(start));
     }
 }
@@ -461,26 +495,29 @@ fn ustringReplace(vm: *cy.VM, str: []const u8, needlev: *cy.heap.String, replace
     }
 }
 
-pub fn repeat(vm: *cy.VM) Value {
+pub fn repeat(vm: *cy.VM) anyerror!Value {
     const obj = vm.getObject(*cy.heap.String, 0);
     const str = obj.getSlice();
 
     const n = vm.getInt(1);
     if (n < 0) {
-        return rt.prepThrowError(vm, .InvalidArgument);
+        return error.InvalidArgument;
     }
 
-    const un: u32 = @intCast(n);
+    if (str.len > 0 and n > cy.heap.MaxStringByteLen / str.len) {
+        return error.StringTooLong;
+    }
+    const un: u32 = @intCast(if (str.len == 0) @min(n, 1) else n);
     const len = un * str.len;
     if (un > 1 and len > 0) {
         var new: *cy.HeapObject = undefined;
         var buf: []u8 = undefined;
         const stype = obj.getType();
         if (stype.isAstring()) {
-            new = vm.allocUnsetAstringObject(len) catch fatal();
+            new = try vm.allocUnsetAstringObject(len);
             buf = new.astring.getMutSlice();
         } else {
-            new = vm.allocUnsetUstringObject(len) catch fatal();
+            new = try vm.allocUnsetUstringObject(len);
             buf = new.ustring.getMutSlice();
         }
         // This is already quite fast since it has good cache locality.
@@ -504,7 +541,42 @@ pub fn repeat(vm: *cy.VM) Value {
     }
 }
 
-pub fn split(vm: *cy.VM) anyerror!Value {
+/// Returns the index of `delim` in `str`. Single byte delimiters take the faster `indexOfChar`.
+fn indexOfDelim(str: []const u8, delim: []const u8) ?usize {
+    if (delim.len > str.len) {
+        return null;
+    }
+    if (delim.len == 1) {
+        return string.indexOfChar(str, delim[0]);
+    }
+    return string.indexOf(str, delim);
+}
+
+/// Returns the part of `str` starting at `pos` and advances `pos` past the next delimiter.
+/// After the last part, `pos` is moved beyond `str.len`.
+fn nextSplit(str: []const u8, delim: []const u8, pos: *usize) ?[]const u8 {
+    if (pos.* > str.len) {
+        return null;
+    }
+    const rest = str[pos.*..];
+    if (indexOfDelim(rest, delim)) |idx| {
+        pos.* += idx + delim.len;
+        return rest[0..idx];
+    }
+    pos.* = str.len + 1;
+    return rest;
+}
+
+fn allocSplitPart(vm: *cy.VM, stype: cy.heap.StringType, parent: *cy.HeapObject, part: []const u8) !Value {
+    vm.retainObject(parent);
+    if (stype.isAstring()) {
+        return vm.allocAstringSlice(part, parent);
+    } else {
+        return vm.allocUstringSlice(part, parent);
+    }
+}
+
+fn splitLimit(vm: *cy.VM, limit: i64) !Value {
     const obj = vm.getObject(*cy.heap.String, 0);
     const str = obj.getSlice();
     const stype = obj.getType();
@@ -512,26 +584,81 @@ pub fn split(vm: *cy.VM) anyerror!Value {
     const delim = vm.getString(1);
 
     const res = try vm.allocEmptyListDyn();
-    if (delim.len == 0) {
+    if (delim.len == 0 or limit == 0) {
         return res;
     }
     const list = res.asHeapObject();
 
-    var iter = std.mem.split(u8, str, delim);
-    while (iter.next()) |part| {
-        if (stype.isAstring()) {
-            vm.retainObject(parent);
-            const partv = try vm.allocAstringSlice(part, parent);
-            try list.list.append(vm.alloc, partv);
-        } else {
-            vm.retainObject(parent);
-            const partv = try vm.allocUstringSlice(part, parent);
+    var pos: usize = 0;
+    var n: i64 = 0;
+    while (pos <= str.len) {
+        n += 1;
+        if (n == limit) {
+            // Last part holds the rest of the string.
+            const partv = try allocSplitPart(vm, stype, parent, str[pos..]);
             try list.list.append(vm.alloc, partv);
+            break;
         }
+        const part = nextSplit(str, delim, &pos).?;
+        const partv = try allocSplitPart(vm, stype, parent, part);
+        try list.list.append(vm.alloc, partv);
     }
     return res;
 }
 
+pub fn split(vm: *cy.VM) anyerror!Value {
+    return splitLimit(vm, -1);
+}
+
+pub fn split2(vm: *cy.VM) anyerror!Value {
+    return splitLimit(vm, vm.getInt(2));
+}
+
+/// Backing state of a `StringSplitIterator` host object.
+/// `str` and `delim` are retained and reported as children.
+pub const StringSplitIterator = extern struct {
+    str: Value,
+    delim: Value,
+    pos: usize,
+};
+
+pub fn splitIter(vm: *cy.VM) anyerror!Value {
+    const data = vm.getData(*cy.builtins.BuiltinsData, "builtins");
+    const str_v = vm.getValue(0);
+    const delim_v = vm.getValue(1);
+
+    const iter: *StringSplitIterator = @ptrCast(@alignCast(try cy.heap.allocHostNoCycObject(vm, data.StringSplitIterator, @sizeOf(StringSplitIterator))));
+    vm.retain(str_v);
+    vm.retain(delim_v);
+    iter.* = .{
+        .str = str_v,
+        .delim = delim_v,
+        // Nothing to visit with an empty delimiter, same as `split`.
+        .pos = if (vm.getString(1).len == 0) vm.getString(0).len + 1 else 0,
+    };
+    return Value.initHostNoCycPtr(iter);
+}
+
+pub fn StringSplitIterator_next(vm: *cy.VM) anyerror!Value {
+    const iter = vm.getHostObject(*StringSplitIterator, 0);
+    const obj = iter.str.castHeapObject(*cy.heap.String);
+    const str = obj.getSlice();
+    const part = nextSplit(str, iter.delim.asString(), &iter.pos) orelse {
+        return cy.builtins.StringNone(vm);
+    };
+    const stype = obj.getType();
+    const partv = try allocSplitPart(vm, stype, obj.getParentByType(stype), part);
+    return cy.builtins.StringSome(vm, partv);
+}
+
+pub fn stringSplitIteratorGetChildren(_: ?*C.VM, obj: ?*anyopaque) callconv(.C) C.ValueSlice {
+    const iter: *StringSplitIterator = @ptrCast(@alignCast(obj));
+    return .{
+        .ptr = @ptrCast(&iter.str),
+        .len = 2,
+    };
+}
+
 pub fn stringCall(vm: *cy.VM) anyerror!Value {
     const val = vm.getValue(0);
     if (val.isString()) {
@@ -541,4 +668,67 @@ pub fn stringCall(vm: *cy.VM) anyerror!Value {
         const str = try vm.getOrBufPrintValueStr(&cy.tempBuf, val);
         return vm.retainOrAllocAstring(str);
     }
-}
\ No newline at end of file
+}
+
+/// Backing state of a `StringBuilder` host object.
+pub const StringBuilder = struct {
+    inner: string.HeapStringBuilder,
+};
+
+pub fn StringBuilder_new(vm: *cy.VM) anyerror!Value {
+    const data = vm.getData(*cy.builtins.BuiltinsData, "builtins");
+    const sb: *StringBuilder = @ptrCast(try cy.heap.allocHostNoCycObject(vm, data.StringBuilder, @sizeOf(StringBuilder)));
+    sb.inner = try string.HeapStringBuilder.init(vm);
+    return Value.initHostNoCycPtr(sb);
+}
+
+pub fn StringBuilder_append(vm: *cy.VM) anyerror!Value {
+    const sb = vm.getHostObject(*StringBuilder, 0);
+    try sb.inner.appendString(vm.getString(1));
+    return Value.Void;
+}
+
+pub fn StringBuilder_appendByte(vm: *cy.VM) anyerror!Value {
+    const sb = vm.getHostObject(*StringBuilder, 0);
+    const byte = vm.getInt(1);
+    if (byte < 0 or byte > 0x7f) {
+        // A lone byte past ASCII would leave invalid UTF-8 in the string.
+        return error.InvalidArgument;
+    }
+    try sb.inner.appendString(&.{ @intCast(byte) });
+    return Value.Void;
+}
+
+pub fn StringBuilder_appendFmt(vm: *cy.VM) anyerror!Value {
+    const sb = vm.getHostObject(*StringBuilder, 0);
+    const str = try vm.getOrBufPrintValueStr(&cy.tempBuf, vm.getValue(1));
+    try sb.inner.appendString(str);
+    return Value.Void;
+}
+
+pub fn StringBuilder_build(vm: *cy.VM) anyerror!Value {
+    const sb = vm.getHostObject(*StringBuilder, 0);
+    const inner = &sb.inner;
+    if (inner.len <= cy.MaxPoolObjectStringByteLen) {
+        // Small results are copied so that the buffer can be reused.
+        const res = try vm.allocString(inner.buf[0..inner.len]);
+        inner.len = 0;
+        inner.isAstring = true;
+        return res;
+    }
+
+    // Hand over the buffer and start a new one.
+    const res = try inner.buildOwned();
+    inner.* = try string.HeapStringBuilder.init(vm);
+    return res;
+}
+
+pub fn StringBuilder_len(vm: *cy.VM) Value {
+    const sb = vm.getHostObject(*StringBuilder, 0);
+    return Value.initInt(@intCast(sb.inner.len));
+}
+
+pub fn stringBuilderFinalizer(_: ?*C.VM, obj: ?*anyopaque) callconv(.C) void {
+    const sb: *StringBuilder = @ptrCast(@alignCast(obj));
+    sb.inner.deinit();
+}
@@ -0,0 +1,411 @@
+// Copyright (c) 2023 Cyber (See LICENSE)
+
+/// Packed numeric arrays for the `math` module.
+/// Elements are stored unboxed and contiguously after a small header so that
+/// bulk operations can run as SIMD kernels instead of per-element dispatch.
+
+const std = @import("std");
+const cy = @import("../cyber.zig");
+const C = @import("../capi.zig");
+const Value = cy.Value;
+const zErrFunc = cy.builtins.zErrFunc;
+
+pub fn TypedArray(comptime T: type) type {
+    return extern struct {
+        len: usize,
+
+        const Self = @This();
+
+        /// Elements begin right after the header.
+        pub inline fn items(self: *Self) []T {
+            const ptr: [*]T = @ptrFromInt(@intFromPtr(self) + @sizeOf(Self));
+            return ptr[0..self.len];
+        }
+    };
+}
+
+pub fn allocTypedArray(vm: *cy.VM, comptime T: type, type_id: cy.TypeId, n: usize) !*TypedArray(T) {
+    const Array = TypedArray(T);
+    const elems_size = std.math.mul(usize, n, @sizeOf(T)) catch return error.InvalidArgument;
+    const size = std.math.add(usize, @sizeOf(Array), elems_size) catch return error.InvalidArgument;
+    const arr: *Array = @ptrCast(try cy.heap.allocHostNoCycObject(vm, type_id, size));
+    arr.len = n;
+    return arr;
+}
+
+const BinOp = enum {
+    add,
+    sub,
+    mul,
+    div,
+};
+
+const UnaryOp = enum {
+    abs,
+    ceil,
+    cos,
+    exp,
+    floor,
+    ln,
+    neg,
+    round,
+    sin,
+    sqrt,
+    trunc,
+};
+
+inline fn vecLen(comptime T: type) comptime_int {
+    return std.simd.suggestVectorLength(T) orelse 1;
+}
+
+inline fn isInt(comptime T: type) bool {
+    return @typeInfo(T) == .Int;
+}
+
+inline fn applyBin(comptime T: type, comptime op: BinOp, a: anytype, b: @TypeOf(a)) @TypeOf(a) {
+    if (comptime isInt(T)) {
+        return switch (op) {
+            .add => a +% b,
+            .sub => a -% b,
+            .mul => a *% b,
+            .div => @compileError("Unsupported."),
+        };
+    } else {
+        return switch (op) {
+            .add => a + b,
+            .sub => a - b,
+            .mul => a * b,
+            .div => a / b,
+        };
+    }
+}
+
+inline fn applyUnary(comptime op: UnaryOp, a: anytype) @TypeOf(a) {
+    return switch (op) {
+        .abs => @abs(a),
+        .ceil => @ceil(a),
+        .cos => @cos(a),
+        .exp => @exp(a),
+        .floor => @floor(a),
+        .ln => @log(a),
+        .neg => -a,
+        .round => @round(a),
+        .sin => @sin(a),
+        .sqrt => @sqrt(a),
+        .trunc => @trunc(a),
+    };
+}
+
+/// `dst[i] = dst[i] op src[i]`. Assumes equal lengths.
+pub fn binKernel(comptime T: type, comptime op: BinOp, dst: []T, src: []const T) void {
+    const N = comptime vecLen(T);
+    var i: usize = 0;
+    if (N > 1) {
+        while (i + N <= dst.len) : (i += N) {
+            const a: @Vector(N, T) = dst[i..][0..N].*;
+            const b: @Vector(N, T) = src[i..][0..N].*;
+            dst[i..][0..N].* = applyBin(T, op, a, b);
+        }
+    }
+    while (i < dst.len) : (i += 1) {
+        dst[i] = applyBin(T, op, dst[i], src[i]);
+    }
+}
+
+/// `dst[i] = dst[i] op s`.
+pub fn scalarKernel(comptime T: type, comptime op: BinOp, dst: []T, s: T) void {
+    const N = comptime vecLen(T);
+    var i: usize = 0;
+    if (N > 1) {
+        const vs: @Vector(N, T) = @splat(s);
+        while (i + N <= dst.len) : (i += N) {
+            const a: @Vector(N, T) = dst[i..][0..N].*;
+            dst[i..][0..N].* = applyBin(T, op, a, vs);
+        }
+    }
+    while (i < dst.len) : (i += 1) {
+        dst[i] = applyBin(T, op, dst[i], s);
+    }
+}
+
+pub fn unaryKernel(comptime T: type, comptime op: UnaryOp, dst: []T) void {
+    const N = comptime vecLen(T);
+    var i: usize = 0;
+    if (N > 1) {
+        while (i + N <= dst.len) : (i += N) {
+            const a: @Vector(N, T) = dst[i..][0..N].*;
+            dst[i..][0..N].* = applyUnary(op, a);
+        }
+    }
+    while (i < dst.len) : (i += 1) {
+        dst[i] = applyUnary(op, dst[i]);
+    }
+}
+
+/// Integer sums wrap like `int` arithmetic.
+pub fn sumKernel(comptime T: type, src: []const T) T {
+    const N = comptime vecLen(T);
+    var res: T = 0;
+    var i: usize = 0;
+    if (N > 1) {
+        var acc: @Vector(N, T) = @splat(0);
+        while (i + N <= src.len) : (i += N) {
+            const a: @Vector(N, T) = src[i..][0..N].*;
+            acc = applyBin(T, .add, acc, a);
+        }
+        const lanes: [N]T = acc;
+        for (lanes) |lane| {
+            res = applyBin(T, .add, res, lane);
+        }
+    }
+    while (i < src.len) : (i += 1) {
+        res = applyBin(T, .add, res, src[i]);
+    }
+    return res;
+}
+
+pub fn dotKernel(comptime T: type, a: []const T, b: []const T) T {
+    const N = comptime vecLen(T);
+    var res: T = 0;
+    var i: usize = 0;
+    if (N > 1) {
+        var acc: @Vector(N, T) = @splat(0);
+        while (i + N <= a.len) : (i += N) {
+            const va: @Vector(N, T) = a[i..][0..N].*;
+            const vb: @Vector(N, T) = b[i..][0..N].*;
+            acc = applyBin(T, .add, acc, applyBin(T, .mul, va, vb));
+        }
+        const lanes: [N]T = acc;
+        for (lanes) |lane| {
+            res = applyBin(T, .add, res, lane);
+        }
+    }
+    while (i < a.len) : (i += 1) {
+        res = applyBin(T, .add, res, applyBin(T, .mul, a[i], b[i]));
+    }
+    return res;
+}
+
+/// Assumes `src.len > 0`.
+pub fn minMaxKernel(comptime T: type, comptime is_max: bool, src: []const T) T {
+    const N = comptime vecLen(T);
+    var res: T = src[0];
+    var i: usize = 0;
+    if (N > 1 and src.len >= N) {
+        var acc: @Vector(N, T) = src[0..N].*;
+        i = N;
+        while (i + N <= src.len) : (i += N) {
+            const a: @Vector(N, T) = src[i..][0..N].*;
+            acc = if (is_max) @max(acc, a) else @min(acc, a);
+        }
+        res = if (is_max) @reduce(.Max, acc) else @reduce(.Min, acc);
+    }
+    while (i < src.len) : (i += 1) {
+        res = if (is_max) @max(res, src[i]) else @min(res, src[i]);
+    }
+    return res;
+}
+
+inline fn fromValue(comptime T: type, val: Value) T {
+    return switch (T) {
+        i64 => val.asInt(),
+        f64 => val.asF64(),
+        f32 => @floatCast(val.asF64()),
+        else => @compileError("Unsupported."),
+    };
+}
+
+inline fn toValue(comptime T: type, val: T) Value {
+    return switch (T) {
+        i64 => Value.initInt(val),
+        f64 => Value.initF64(val),
+        f32 => Value.initF64(val),
+        else => @compileError("Unsupported."),
+    };
+}
+
+/// Host functions for a typed array. `type_field` names the type id field in `CoreData`.
+fn Funcs(comptime T: type, comptime type_field: []const u8) type {
+    return struct {
+        const Array = TypedArray(T);
+
+        fn getTypeId(vm: *cy.VM) cy.TypeId {
+            const core_data = vm.getData(*cy.builtins.CoreData, "core");
+            return @field(core_data, type_field);
+        }
+
+        fn new(vm: *cy.VM) anyerror!Value {
+            const n = vm.getInt(0);
+            if (n < 0) {
+                return error.InvalidArgument;
+            }
+            const arr = try allocTypedArray(vm, T, getTypeId(vm), @intCast(n));
+            @memset(arr.items(), fromValue(T, vm.getValue(1)));
+            return Value.initHostNoCycPtr(arr);
+        }
+
+        fn fromList(vm: *cy.VM) anyerror!Value {
+            const elems = vm.getValue(0).asHeapObject().list.items();
+            const arr = try allocTypedArray(vm, T, getTypeId(vm), elems.len);
+            for (arr.items(), elems) |*dst, elem| {
+                dst.* = fromValue(T, elem);
+            }
+            return Value.initHostNoCycPtr(arr);
+        }
+
+        fn index(vm: *cy.VM) Value {
+            const arr = vm.getHostObject(*Array, 0);
+            const idx = vm.getInt(1);
+            if (idx < 0 or idx >= arr.len) {
+                return vm.prepPanic("Out of bounds.");
+            }
+            return toValue(T, arr.items()[@intCast(idx)]);
+        }
+
+        fn setIndex(vm: *cy.VM) Value {
+            const arr = vm.getHostObject(*Array, 0);
+            const idx = vm.getInt(1);
+            if (idx < 0 or idx >= arr.len) {
+                return vm.prepPanic("Out of bounds.");
+            }
+            arr.items()[@intCast(idx)] = fromValue(T, vm.getValue(2));
+            return Value.Void;
+        }
+
+        fn len(vm: *cy.VM) Value {
+            const arr = vm.getHostObject(*Array, 0);
+            return Value.initInt(@intCast(arr.len));
+        }
+
+        fn binOp(comptime op: BinOp) cy.ZHostFuncFn {
+            const S = struct {
+                fn func(vm: *cy.VM) Value {
+                    const arr = vm.getHostObject(*Array, 0);
+                    const o = vm.getHostObject(*Array, 1);
+                    if (arr.len != o.len) {
+                        return vm.prepPanic("Length mismatch.");
+                    }
+                    binKernel(T, op, arr.items(), o.items());
+                    return Value.Void;
+                }
+            };
+            return &S.func;
+        }
+
+        fn scale(vm: *cy.VM) Value {
+            const arr = vm.getHostObject(*Array, 0);
+            scalarKernel(T, .mul, arr.items(), fromValue(T, vm.getValue(1)));
+            return Value.Void;
+        }
+
+        fn sum(vm: *cy.VM) Value {
+            const arr = vm.getHostObject(*Array, 0);
+            return toValue(T, sumKernel(T, arr.items()));
+        }
+
+        fn dot(vm: *cy.VM) Value {
+            const arr = vm.getHostObject(*Array, 0);
+            const o = vm.getHostObject(*Array, 1);
+            if (arr.len != o.len) {
+                return vm.prepPanic("Length mismatch.");
+            }
+            return toValue(T, dotKernel(T, arr.items(), o.items()));
+        }
+
+        fn minMax(comptime is_max: bool) cy.ZHostFuncFn {
+            const S = struct {
+                fn func(vm: *cy.VM) Value {
+                    const arr = vm.getHostObject(*Array, 0);
+                    if (arr.len == 0) {
+                        return vm.prepPanic("Empty array.");
+                    }
+                    return toValue(T, minMaxKernel(T, is_max, arr.items()));
+                }
+            };
+            return &S.func;
+        }
+
+        fn map(vm: *cy.VM) anyerror!Value {
+            const arr = vm.getHostObject(*Array, 0);
+            const name = vm.getSymbolName(vm.getSymbol(1));
+            const op = std.meta.stringToEnum(UnaryOp, name) orelse {
+                return error.InvalidArgument;
+            };
+            switch (op) {
+                inline else => |op_t| unaryKernel(T, op_t, arr.items()),
+            }
+            return Value.Void;
+        }
+
+        fn sort(vm: *cy.VM) Value {
+            const arr = vm.getHostObject(*Array, 0);
+            std.mem.sortUnstable(T, arr.items(), {}, std.sort.asc(T));
+            return Value.Void;
+        }
+
+        fn toList(vm: *cy.VM) anyerror!Value {
+            const arr = vm.getHostObject(*Array, 0);
+            const list_t: cy.TypeId = @intCast(vm.getInt(1));
+            const list = try vm.allocListFill(list_t, cy.types.BuiltinTypes.Void, Value.Void, @intCast(arr.len));
+            for (list.asHeapObject().list.items(), arr.items()) |*dst, elem| {
+                dst.* = toValue(T, elem);
+            }
+            return list;
+        }
+
+        fn entries(comptime name: []const u8) []const C.HostFuncEntry {
+            const func = cy.hostFuncEntry;
+            const common = [_]C.HostFuncEntry{
+                func(name ++ ".$index",    index),
+                func(name ++ ".$setIndex", setIndex),
+                func(name ++ ".add",       binOp(.add)),
+                func(name ++ ".dot",       dot),
+                func(name ++ ".len",       len),
+                func(name ++ ".max",       minMax(true)),
+                func(name ++ ".min",       minMax(false)),
+                func(name ++ ".mul",       binOp(.mul)),
+                func(name ++ ".scale",     scale),
+                func(name ++ ".sort",      sort),
+                func(name ++ ".sub",       binOp(.sub)),
+                func(name ++ ".sum",       sum),
+                func(name ++ ".toList_",   zErrFunc(toList)),
+                func(name ++ ".fromList",  zErrFunc(fromList)),
+                func(name ++ ".new",       zErrFunc(new)),
+            };
+            if (comptime isInt(T)) {
+                return &common;
+            } else {
+                return &(common ++ [_]C.HostFuncEntry{
+                    func(name ++ ".div",   binOp(.div)),
+                    func(name ++ ".map",   zErrFunc(map)),
+                });
+            }
+        }
+    };
+}
+
+pub const funcs = Funcs(f64, "Float64ArrayT").entries("Float64Array") ++
+    Funcs(f32, "Float32ArrayT").entries("Float32Array") ++
+    Funcs(i64, "Int64ArrayT").entries("Int64Array");
+
+test "typed array kernels." {
+    const t = @import("stdx").testing;
+
+    var a = [_]f64{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    const b = [_]f64{ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+    try t.eq(sumKernel(f64, &a), 66);
+    try t.eq(dotKernel(f64, &a, &b), 66);
+    try t.eq(minMaxKernel(f64, true, &a), 11);
+    try t.eq(minMaxKernel(f64, false, &a), 1);
+    binKernel(f64, .add, &a, &b);
+    try t.eq(a[10], 12);
+    scalarKernel(f64, .mul, &a, 2);
+    try t.eq(a[0], 4);
+    unaryKernel(f64, .sqrt, &a);
+    try t.eq(a[0], 2);
+
+    var ia = [_]i64{ 5, -3, 9, 0, 2, 7, 1 };
+    try t.eq(sumKernel(i64, &ia), 21);
+    try t.eq(minMaxKernel(i64, false, &ia), -3);
+    try t.eq(minMaxKernel(i64, true, &ia), 9);
+}
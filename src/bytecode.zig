@@ -168,6 +168,12 @@ pub const ByteCodeBuffer = struct {
     }
 
     pub fn pushFailableDebugSym(self: *ByteCodeBuffer, pc: usize, file: u32, loc: u32, frameLoc: u32, unwind_key: cy.fiber.UnwindKey) !void {
+        if (cy.Trace) {
+            // `debug.indexOfDebugSymFromTable` expects the table to be ordered by pc.
+            if (self.debugTable.items.len > 0 and self.debugTable.items[self.debugTable.items.len-1].pc > pc) {
+                @panic("Unordered debug sym.");
+            }
+        }
         try self.debugTable.append(self.alloc, .{
             .pc = @intCast(pc),
             .loc = loc,
@@ -371,7 +377,8 @@ pub fn dumpInst(vm: *cy.VM, pcOffset: u32, code: OpCode, pc: [*]const Inst, opts
             const dst = pc[2].val;
             len += try fmt.printCount(w, "local={}, dst={}", &.{v(local), v(dst)});
         },
-        .captured => {
+        .captured,
+        .captured_value => {
             const closure = pc[1].val;
             const varIdx = pc[2].val;
             const retain = pc[3].val;
@@ -1039,6 +1046,7 @@ pub fn getInstLenAt(pc: [*]const Inst) u8 {
         .typeCheck,
         .field,
         .captured,
+        .captured_value,
         .box,
         .unbox,
         .unwrapChoice,
@@ -1271,6 +1279,11 @@ pub const OpCode = enum(u8) {
     set_up_value = vmc.CodeSetUpValue,
     up_value = vmc.CodeUpValue,
     captured = vmc.CodeCaptured,
+
+    /// Loads a var that was captured by value.
+    /// [closureLocal] [varIdx] [retain] [dst]
+    captured_value = vmc.CodeCapturedValue,
+
     setCaptured = vmc.CodeSetCaptured,
     tag_lit = vmc.CodeTagLit,
     enumOp = vmc.CodeEnum,
@@ -1332,7 +1345,7 @@ pub const OpCode = enum(u8) {
 };
 
 test "bytecode internals." {
-    try t.eq(std.enums.values(OpCode).len, 130);
+    try t.eq(std.enums.values(OpCode).len, 131);
     try t.eq(@sizeOf(Inst), 1);
     if (cy.is32Bit) {
         try t.eq(@sizeOf(DebugMarker), 16);
@@ -12,6 +12,7 @@ var CyberPath: []const u8 = "";
 
 const CyberDir = ".cyber";
 const EntriesDir = "entries";
+const FfiDir = "ffi";
 
 fn getCyberPath(alloc: std.mem.Allocator) ![]const u8 {
     const S = struct {
@@ -31,10 +32,25 @@ fn getCyberPath(alloc: std.mem.Allocator) ![]const u8 {
         var cyberDir = try dir.makeOpenPath(CyberDir, .{});
         defer cyberDir.close();
         try cyberDir.makePath(EntriesDir);
+        try cyberDir.makePath(FfiDir);
     }
     return CyberPath;
 }
 
+/// Overrides the directory of compiled FFI shims. Tests point this at a temp dir.
+pub var FfiShimDirOverride: ?[]const u8 = null;
+
+/// Returns the path of a compiled FFI shim library with the given key.
+pub fn getFfiShimPath(alloc: std.mem.Allocator, key: []const u8) ![]const u8 {
+    const fileName = try std.fmt.allocPrint(alloc, "{s}.so", .{key});
+    defer alloc.free(fileName);
+    if (FfiShimDirOverride) |dir| {
+        return std.fs.path.join(alloc, &.{dir, fileName});
+    }
+    const cyberPath = try getCyberPath(alloc);
+    return std.fs.path.join(alloc, &.{cyberPath, FfiDir, fileName});
+}
+
 fn toCacheSpec(spec: []const u8) ![]const u8 {
     // Remove scheme part.
     if (std.mem.startsWith(u8, spec, "http://")) {
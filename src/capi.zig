@@ -378,6 +378,14 @@ pub const ZVM = struct {
         return c.clFindType(@ptrCast(self), toStr(path));
     }
 
+    pub fn findFunc(self: *ZVM, path: []const u8, out: *Value) bool {
+        return c.clFindFunc(@ptrCast(self), toStr(path), out);
+    }
+
+    pub fn call(self: *ZVM, func: Value, args: []const Value, out: *Value) ResultCode {
+        return c.clCall(@ptrCast(self), func, args.ptr, args.len, out);
+    }
+
     pub fn getField(self: *ZVM, rec: Value, name: []const u8) Value {
         return c.clGetField(@ptrCast(self), rec, toStr(name));
     }
@@ -397,6 +405,7 @@ pub const ZVM = struct {
 
 pub const Sym = c.CLSym;
 pub const GCResult = c.CLGCResult;
+pub const HeapStats = c.CLHeapStats;
 pub const FieldInit = c.CLFieldInit;
 pub fn toFieldInit(name: []const u8, val: Value) FieldInit {
     return .{ .name = toStr(name), .value = val };
@@ -640,23 +640,33 @@ pub fn gen(self: *cy.Compiler) !cy.compiler.AotCompileResult {
             return error.TCCError;
         }
     } else {
-        const res = try std.ChildProcess.run(.{
-            .allocator = self.alloc,
-            .argv = &.{"clang", "-o", exePath, outPath, "zig-out/lib/librt.a"},
-        });
-        defer self.alloc.free(res.stderr);
-        defer self.alloc.free(res.stdout);
-
-        if (res.term != .Exited or res.term.Exited != 0) {
-            rt.err(self.vm, res.stderr);
-            return error.CCError;
-        }
+        try runCC(self, &.{"clang", "-O2", "-o", exePath, outPath, "zig-out/lib/librt.a"});
     }
     return .{
         .exePath = exePath,
     };
 }
 
+fn runCC(self: *cy.Compiler, argv: []const []const u8) !void {
+    const res = std.ChildProcess.run(.{
+        .allocator = self.alloc,
+        .argv = argv,
+    }) catch |err| {
+        if (err == error.FileNotFound) {
+            rt.errZFmt(self.vm, "`{s}` was not found.\n", .{argv[0]});
+            return error.CCError;
+        }
+        return err;
+    };
+    defer self.alloc.free(res.stderr);
+    defer self.alloc.free(res.stdout);
+
+    if (res.term != .Exited or res.term.Exited != 0) {
+        rt.err(self.vm, res.stderr);
+        return error.CCError;
+    }
+}
+
 fn genHead(c: *Compiler, w: std.ArrayListUnmanaged(u8).Writer, chunks: []Chunk) !void {
     _ = c;
     const head = @embedFile("pm.h");
@@ -831,7 +841,7 @@ fn genStmt(c: *Chunk, loc: u32) anyerror!void {
     }
     switch (code) {
         .breakStmt          => try breakStmt(c, node),
-        // .contStmt           => try contStmt(c, node),
+        .contStmt           => try contStmt(c, node),
         .declareLocal       => try declareLocal(c, loc, node),
         .declareLocalInit   => try declareLocalInit(c, loc, node),
         // .destrElemsStmt     => try destrElemsStmt(c, idx, node),
@@ -845,7 +855,7 @@ fn genStmt(c: *Chunk, loc: u32) anyerror!void {
         .opSet              => try opSet(c, loc, node),
         // .pushDebugLabel     => try pushDebugLabel(c, idx),
         .retExprStmt        => try retExprStmt(c, loc, node),
-        // .retStmt            => try retStmt(c),
+        .retStmt            => try retStmt(c, node),
         // .setCaptured        => try setCaptured(c, idx, node),
         .set_field          => try setField(c, loc, node),
         // .setFuncSym         => try setFuncSym(c, idx, node),
@@ -901,12 +911,12 @@ fn genExpr(c: *Chunk, loc: usize, cstr: Cstr) anyerror!Value {
         // .coyield            => genCoyield(c, idx, cstr, node),
         // .enumMemberSym      => genEnumMemberSym(c, idx, cstr, node),
         // .errorv             => genError(c, idx, cstr, node),
-        // .falsev             => genFalse(c, cstr, node),
+        .falsev             => genFalse(c, cstr, node),
         // .fieldDynamic       => genFieldDynamic(c, idx, cstr, .{}, node),
         .field              => genField(c, loc, cstr, node),
-        // .float              => genFloat(c, idx, cstr, node),
+        .float              => genFloat(c, loc, cstr, node),
         // .funcSym            => genFuncSym(c, idx, cstr, node),
-        // .ifExpr             => genIfExpr(c, idx, cstr, node),
+        .if_expr            => genIfExpr(c, loc, cstr, node),
         .int                => genInt(c, loc, cstr, node),
         // .lambda             => genLambda(c, idx, cstr, node),
         // .list               => genList(c, idx, cstr, node),
@@ -918,13 +928,13 @@ fn genExpr(c: *Chunk, loc: usize, cstr: Cstr) anyerror!Value {
         .call_dyn           => genCallDyn(c, loc, cstr, node),
         .call_sym           => genCallFuncSym(c, loc, cstr, node),
         // .preCallObjSym      => genCallObjSym(c, idx, cstr, node),
-        // .preUnOp            => genUnOp(c, idx, cstr, node),
+        .preUnOp            => genUnOp(c, loc, cstr, node),
         .string             => genString(c, loc, cstr, node),
         // .stringTemplate     => genStringTemplate(c, idx, cstr, node),
         // .switchBlock        => genSwitchBlock(c, idx, cstr, node),
         .symbol             => genSymbol(c, loc, cstr, node),
         // .throw              => genThrow(c, idx, node),
-        // .truev              => genTrue(c, cstr, node),
+        .truev              => genTrue(c, cstr, node),
         // .tryExpr            => genTryExpr(c, idx, cstr, node),
         // .typeSym            => genTypeSym(c, idx, cstr, node),
         // .varSym             => genVarSym(c, idx, cstr, node),
@@ -1008,15 +1018,14 @@ fn declareLocalInit(c: *Chunk, idx: u32, node: *ast.Node) !void {
 }
 
 fn declareLocal(c: *Chunk, idx: u32, node: *ast.Node) !void {
-    _ = c;
-    _ = idx;
-    _ = node;
+    const data = c.ir.getStmtData(idx, .declareLocal);
 
-    // const reg = try bcgen.reserveLocalReg(c, data.id, data.declType, data.isBoxed, node, true);
+    reserveLocal(c, data.id, data.name(), data.declType, data.lifted);
 
-    // // Not yet initialized, so it does not have a refcount.
-    // bcgen.getLocalInfoPtr(c, reg).some.rcCandidate = false;
-    return error.TODO;
+    // Not yet initialized, so it does not have a refcount.
+    const start = c.bufStart();
+    try c.bufPushFmt("{} {s};", .{try c.cTypeName(data.declType), data.name()});
+    try c.pushLine(c.bufPop(start), node);
 }
 
 fn getBinOpName(op: cy.BinaryExprOp) []const u8 {
@@ -1141,6 +1150,37 @@ fn genSymbol(c: *Chunk, loc: usize, cstr: Cstr, node: *ast.Node) !Value {
     return Value{};
 }
 
+fn genTrue(c: *Chunk, cstr: Cstr, node: *ast.Node) !Value {
+    _ = cstr;
+    _ = node;
+    try c.bufPush("true");
+    return Value{};
+}
+
+fn genFalse(c: *Chunk, cstr: Cstr, node: *ast.Node) !Value {
+    _ = cstr;
+    _ = node;
+    try c.bufPush("false");
+    return Value{};
+}
+
+fn genFloat(c: *Chunk, loc: usize, cstr: Cstr, node: *ast.Node) !Value {
+    _ = cstr;
+    _ = node;
+    const data = c.ir.getExprData(loc, .float);
+
+    // C has no literals for non-finite doubles without math.h.
+    if (std.math.isNan(data.val)) {
+        try c.bufPush("(0.0/0.0)");
+    } else if (std.math.isInf(data.val)) {
+        try c.bufPush(if (data.val > 0) "(1.0/0.0)" else "(-1.0/0.0)");
+    } else {
+        // Scientific notation always yields a double literal, even for integral values.
+        try c.bufPushFmt("{e}", .{data.val});
+    }
+    return Value{};
+}
+
 fn genInt(c: *Chunk, loc: usize, cstr: Cstr, node: *ast.Node) !Value {
     _ = cstr;
     _ = node;
@@ -1576,12 +1616,75 @@ fn breakStmt(c: *Chunk, node: *ast.Node) !void {
     try c.pushLine("break;", node);
 }
 
+fn contStmt(c: *Chunk, node: *ast.Node) !void {
+    try c.pushLine("continue;", node);
+}
+
+fn retStmt(c: *Chunk, node: *ast.Node) !void {
+    if (c.proc().type == .main) {
+        try c.pushLine("return 0;", node);
+    } else {
+        try c.pushLine("return;", node);
+    }
+}
+
+fn genIfExpr(c: *Chunk, loc: usize, cstr: Cstr, node: *ast.Node) !Value {
+    _ = node;
+    const data = c.ir.getExprData(loc, .if_expr);
+
+    try c.bufPush("(");
+    const cond_t = c.ir.getExprType(data.cond);
+    if (cond_t.id == bt.Any) {
+        try c.bufPush("TRY_UNBOX_BOOL(");
+    }
+    _ = try genExpr(c, data.cond, Cstr.init());
+    if (cond_t.id == bt.Any) {
+        try c.bufPush(")");
+    }
+    try c.bufPush(" ? ");
+    _ = try genExpr(c, data.body, cstr);
+    try c.bufPush(" : ");
+    _ = try genExpr(c, data.elseBody, cstr);
+    try c.bufPush(")");
+    return Value{};
+}
+
+fn genUnOp(c: *Chunk, loc: usize, cstr: Cstr, node: *ast.Node) !Value {
+    _ = cstr;
+    const data = c.ir.getExprData(loc, .preUnOp).unOp;
+
+    switch (data.op) {
+        .minus => {
+            if (data.childT != bt.Integer and data.childT != bt.Float) return error.TODO;
+            try c.bufPush("(-");
+        },
+        .not => {
+            if (data.childT != bt.Boolean) return error.TODO;
+            try c.bufPush("(!");
+        },
+        .bitwiseNot => {
+            if (data.childT != bt.Integer) return error.TODO;
+            try c.bufPush("(~");
+        },
+        else => {
+            return c.base.reportErrorFmt("Unsupported op: {}", &.{v(data.op)}, node);
+        },
+    }
+    _ = try genExpr(c, data.expr, Cstr.init());
+    try c.bufPush(")");
+    return Value{};
+}
+
 fn ifStmt(c: *Chunk, loc: usize, node: *ast.Node) !void {
     const data = c.ir.getStmtData(loc, .ifStmt);
 
     const start = c.bufStart();
     try c.bufPush("if (");
 
+    const hint = branchHint(c, node);
+    if (hint) |macro| {
+        try c.bufPush(macro);
+    }
     const cond_t = c.ir.getExprType(data.cond);
     if (cond_t.id == bt.Any) {
         try c.bufPush("TRY_UNBOX_BOOL(");
@@ -1595,6 +1698,9 @@ fn ifStmt(c: *Chunk, loc: usize, node: *ast.Node) !void {
     if (cond_t.id == bt.Any) {
         try c.pushSpan(")");
     }
+    if (hint != null) {
+        try c.pushSpan(")");
+    }
     try c.pushSpanEnd(") {");
 
     // // ARC cleanup for true case.
@@ -1606,44 +1712,63 @@ fn ifStmt(c: *Chunk, loc: usize, node: *ast.Node) !void {
     try genStmts(c, data.body_head);
     c.popBlock();
 
-    if (data.else_block != cy.NullId) {
-        const else_loc = data.else_block;
-        while (else_loc != cy.NullId) {
-            try c.pushLineNoMapping("} else {");
-            c.pushBlock();
+    var else_loc = data.else_block;
+    while (else_loc != cy.NullId) {
+        const else_nid = c.ir.getNode(else_loc);
+        const else_data = c.ir.getExprData(else_loc, .else_block);
 
-            const else_nid = c.ir.getNode(else_loc);
-            const else_data = c.ir.getExprData(else_loc, .else_block);
+        if (else_data.cond != cy.NullId) {
+            cond_nid = c.ir.getNode(else_data.cond);
+            const elseif_cond_t = c.ir.getExprType(else_data.cond);
 
-            if (else_data.cond != cy.NullId) {
-                cond_nid = c.ir.getNode(else_data.cond);
+            const elseif_start = c.bufStart();
+            try c.bufPush("} else if (");
+            const elseif_hint = branchHint(c, else_nid);
+            if (elseif_hint) |macro| {
+                try c.bufPush(macro);
+            }
+            if (elseif_cond_t.id == bt.Any) {
+                try c.bufPush("TRY_UNBOX_BOOL(");
+            }
+            _ = try genExpr(c, else_data.cond, Cstr.init());
+            if (elseif_cond_t.id == bt.Any) {
+                try c.bufPush(")");
+            }
+            if (elseif_hint != null) {
+                try c.bufPush(")");
+            }
 
-                const elseif_start = c.bufStart();
-                try c.bufPush("if (");
-                _ = try genExpr(c, else_data.cond, Cstr.init());
+            try c.beginLine(else_nid);
+            try c.pushSpan(c.bufPop(elseif_start));
+            try c.pushSpanEnd(") {");
 
-                try c.beginLine(else_nid);
-                try c.pushSpan(c.bufPop(elseif_start));
-                try c.pushSpanEnd(") {");
+            // try pushUnwindValue(c, condv);
 
-                c.pushBlock();
-                try genStmts(c, else_data.body_head);
-                c.popBlock();
+            // // ARC cleanup for true case.
+            // try popTempAndUnwind(c, condv);
+            // try releaseTempValue(c, condv, cond_nid);
+        } else {
+            try c.pushLineNoMapping("} else {");
+        }
 
-                // try pushUnwindValue(c, condv);
+        c.pushBlock();
+        try genStmts(c, else_data.body_head);
+        c.popBlock();
 
-                // // ARC cleanup for true case.
-                // try popTempAndUnwind(c, condv);
-                // try releaseTempValue(c, condv, cond_nid);
-            } else {
-                try genStmts(c, else_data.body_head);
-            }
-            c.popBlock();
-        }
+        else_loc = else_data.else_block;
     }
     try c.pushLineNoMapping("}");
 }
 
+/// Returns `LIKELY(` or `UNLIKELY(` when a loaded profile shows that the branch at `node` is biased,
+/// so the C compiler can lay out the hot path as the fall through.
+fn branchHint(c: *Chunk, node: *ast.Node) ?[]const u8 {
+    const hints = c.base.compiler.profile_hints orelse return null;
+    const branch = hints.getBranch(c.base, node.pos()) orelse return null;
+    const bias = branch.bias() orelse return null;
+    return if (bias) "LIKELY(" else "UNLIKELY(";
+}
+
 const BinOpOptions = struct {
     left: ?Value = null,
 };
@@ -1653,12 +1778,17 @@ fn genBinOp(c: *Chunk, loc: usize, cstr: Cstr, opts: BinOpOptions, node: *ast.No
     const data = c.ir.getExprData(loc, .preBinOp).binOp;
     log.tracev("binop {} {}", .{data.op, data.leftT});
 
-    if (data.op == .and_op) {
-        return error.TODO;
-        // return genAndOp(c, idx, data, cstr, node);
-    } else if (data.op == .or_op) {
-        return error.TODO;
-        // return genOr(c, idx, data, cstr, node);
+    if (data.op == .and_op or data.op == .or_op) {
+        // Only short-circuiting on bools maps directly to C. `dyn` operands return the operand itself.
+        if (data.leftT != bt.Boolean or data.rightT != bt.Boolean) {
+            return error.TODO;
+        }
+        try c.bufPush("(");
+        _ = try genExpr(c, data.left, Cstr.init());
+        try c.bufPush(if (data.op == .and_op) " && " else " || ");
+        _ = try genExpr(c, data.right, Cstr.init());
+        try c.bufPush(")");
+        return Value{};
     }
 
     // // Most builtin binOps do not retain.
@@ -1680,7 +1810,10 @@ fn genBinOp(c: *Chunk, loc: usize, cstr: Cstr, opts: BinOpOptions, node: *ast.No
                 });
             }
         },
-        else => {},
+        else => {
+            // C's precedence differs from Cyber's. eg. `==` binds tighter than `&`.
+            try c.bufPush("(");
+        },
     }
 
     // Lhs.
@@ -1705,12 +1838,18 @@ fn genBinOp(c: *Chunk, loc: usize, cstr: Cstr, opts: BinOpOptions, node: *ast.No
         },
         .bitwiseAnd,
         .bitwiseOr,
-        .bitwiseXor,
+        .bitwiseXor => {
+            if (data.leftT != bt.Integer or data.rightT != bt.Integer) {
+                return error.TODO;
+            }
+            try c.bufPush(cBinOpLit(data.op));
+        },
         .bitwiseLeftShift,
         .bitwiseRightShift => {
-            // if (data.leftT == bt.Integer) {
-            //     try pushInlineBinExpr(c, getIntOpCode(data.op), leftv.local, rightv.local, inst.dst, node);
-            // } else return error.Unexpected;
+            // Out of range shift amounts panic in the VM.
+            return error.TODO;
+        },
+        .caret => {
             return error.TODO;
         },
         .greater,
@@ -1720,11 +1859,11 @@ fn genBinOp(c: *Chunk, loc: usize, cstr: Cstr, opts: BinOpOptions, node: *ast.No
         .star,
         .slash,
         .percent,
-        .caret,
         .plus,
         .minus => {
             if (data.leftT == bt.Float) {
-                if (data.rightT == bt.Float) {
+                // C has no `%` for doubles.
+                if (data.rightT == bt.Float and data.op != .percent) {
                     try c.bufPush(cBinOpLit(data.op));
                 } else {
                     return error.TODO;
@@ -1737,15 +1876,18 @@ fn genBinOp(c: *Chunk, loc: usize, cstr: Cstr, opts: BinOpOptions, node: *ast.No
                 }
             } else return error.Unexpected;
         },
-        .equal_equal => {
-            // try c.pushOptionalDebugSym(node);
-            // try c.buf.pushOp3Ext(.compare, leftv.local, rightv.local, inst.dst, c.desc(node));
-            return error.TODO;
-        },
+        .equal_equal,
         .bang_equal => {
-            // try c.pushOptionalDebugSym(node);
-            // try c.buf.pushOp3Ext(.compareNot, leftv.local, rightv.local, inst.dst, c.desc(node));
-            return error.TODO;
+            // Only primitives compare by value in C.
+            if (data.leftT != data.rightT) {
+                return error.TODO;
+            }
+            switch (data.leftT) {
+                bt.Integer,
+                bt.Float,
+                bt.Boolean => try c.bufPush(cBinOpLit(data.op)),
+                else => return error.TODO,
+            }
         },
         else => {
             return c.base.reportErrorFmt("Unsupported op: {}", &.{v(data.op)}, node);
@@ -1762,7 +1904,9 @@ fn genBinOp(c: *Chunk, loc: usize, cstr: Cstr, opts: BinOpOptions, node: *ast.No
                 try c.bufPush(")");
             }
         },
-        else => {},
+        else => {
+            try c.bufPush(")");
+        },
     }
 
     // const leftRetained = if (opts.left == null) unwindTempKeepDst(c, leftv, inst.dst) else false;
@@ -1787,7 +1931,11 @@ fn cBinOpLit(op: cy.BinaryExprOp) []const u8 {
         .slash => " / ",
         .percent => " % ",
         .star => " * ",
-        .caret => cy.fatal(),
+        .bitwiseAnd => " & ",
+        .bitwiseOr => " | ",
+        .bitwiseXor => " ^ ",
+        .equal_equal => " == ",
+        .bang_equal => " != ",
         else => cy.fatal(),
     };
 }
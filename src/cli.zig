@@ -15,6 +15,7 @@ const builtins = std.ComptimeStringMap(void, .{
     .{"core"},
     .{"math"},
     .{"cy"},
+    .{"json"},
 });
 
 const Src = @embedFile("std/cli.cy");
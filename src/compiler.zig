@@ -14,6 +14,7 @@ const bt = cy.types.BuiltinTypes;
 const core_mod = @import("builtins/builtins.zig");
 const cy_mod = @import("builtins/cy.zig");
 const math_mod = @import("builtins/math.zig");
+const json_mod = @import("builtins/json.zig");
 const llvm_gen = @import("llvm_gen.zig");
 const cgen = @import("cgen.zig");
 const bcgen = @import("bc_gen.zig");
@@ -65,7 +66,7 @@ pub const Compiler = struct {
     /// Key is either a *Sym or *Func.
     genSymMap: std.AutoHashMapUnmanaged(*anyopaque, bcgen.Sym),
 
-    /// Key to VM.vtables index.
+    /// Key to VMC.vtables index.
     gen_vtables: std.AutoHashMapUnmanaged(bcgen.VtableKey, u32),
 
     /// Imports are queued.
@@ -73,6 +74,10 @@ pub const Compiler = struct {
 
     config: C.CompileConfig,
 
+    /// Branch outcomes and loop trip counts from an earlier `-profile` run.
+    /// The C backend uses them to lay out biased branches. Not owned by the compiler.
+    profile_hints: ?*const cy.profile.Hints = null,
+
     /// Tracks whether an error was set from the API.
     hasApiError: bool,
     apiError: []const u8, // Duped so Cyber owns the msg.
@@ -457,8 +462,10 @@ pub const Compiler = struct {
                     return .{ .aot = res };
                 },
                 C.BackendLLVM => {
+                    // llvm_gen.zig is written against the old sema (`VMcompiler`, `semaFuncDecls`)
+                    // and LLVM is not linked by build.zig, so there is no LLVM backend to run.
                     // try llvm_gen.genNativeBinary(self);
-                    return error.TODO;
+                    return error.Unsupported;
                 },
                 C.BackendVM => {
                     try bcgen.genAll(self);
@@ -1178,6 +1185,9 @@ pub fn defaultModuleLoader(vm_: ?*C.VM, spec: C.Str, res: ?*C.Module) callconv(.
     } else if (std.mem.eql(u8, name, "cy")) {
         res.?.* = cy_mod.create(vm, name);
         return true;
+    } else if (std.mem.eql(u8, name, "json")) {
+        res.?.* = json_mod.create(vm, name);
+        return true;
     }
     return false;
 }
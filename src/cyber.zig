@@ -90,6 +90,9 @@ pub const StackFrame = debug.StackFrame;
 
 pub const string = @import("string.zig");
 
+pub const profile = @import("profile.zig");
+pub const Profile = profile.Profile;
+
 pub const bytecode = @import("bytecode.zig");
 pub const ByteCodeBuffer = bytecode.ByteCodeBuffer;
 pub const OpCode = bytecode.OpCode;
@@ -107,6 +110,8 @@ pub const EncodeListContext = cyon.EncodeListContext;
 pub const DecodeTableIR = cyon.DecodeTableIR;
 pub const DecodeListIR = cyon.DecodeListIR;
 pub const DecodeValueIR = cyon.DecodeValueIR;
+pub const CyonDecoder = cyon.Decoder;
+pub const CyonStreamEncoder = cyon.StreamEncoder;
 
 pub const simd = @import("simd.zig");
 
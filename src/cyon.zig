@@ -636,6 +636,522 @@ pub const DecodeValueIR = struct {
     }
 };
 
+/// Single-pass CYON decoder. Values are handed to `builder` as soon as they are scanned,
+/// so no AST or intermediate table IR is built. `builder` is a pointer to a type with:
+///
+///     Value, List, Table
+///     newList() !List, listAppend(*List, Value) !void, endList(*List) !Value, abortList(*List) void
+///     newTable() !Table, tableSet(*Table, key: []const u8, Value) !void, endTable(*Table) !Value, abortTable(*Table) void
+///     string([]const u8) !Value, int(i64) !Value, float(f64) !Value, boolean(bool) !Value
+///     release(Value) void
+///
+/// Slices given to the builder are only valid for the duration of the call.
+pub const Decoder = struct {
+    alloc: std.mem.Allocator,
+    src: []const u8,
+    pos: usize,
+
+    /// Scratch space for unescaped strings.
+    buf: std.ArrayListUnmanaged(u8),
+
+    pub fn init(alloc: std.mem.Allocator, src: []const u8) Decoder {
+        return .{
+            .alloc = alloc,
+            .src = src,
+            .pos = 0,
+            .buf = .{},
+        };
+    }
+
+    pub fn deinit(self: *Decoder) void {
+        self.buf.deinit(self.alloc);
+    }
+
+    /// Decodes the root value. Only whitespace and comments may follow it.
+    pub fn decode(self: *Decoder, builder: anytype) !@TypeOf(builder.*).Value {
+        const val = try self.decodeValue(builder);
+        errdefer builder.release(val);
+        self.skipSpace();
+        if (self.pos < self.src.len) {
+            return error.ParseError;
+        }
+        return val;
+    }
+
+    fn decodeValue(self: *Decoder, builder: anytype) anyerror!@TypeOf(builder.*).Value {
+        self.skipSpace();
+        if (self.pos >= self.src.len) {
+            return error.ParseError;
+        }
+        switch (self.src[self.pos]) {
+            '{' => {
+                self.pos += 1;
+                if (self.isTableBody()) {
+                    return self.decodeTable(builder);
+                } else {
+                    return self.decodeList(builder);
+                }
+            },
+            '\'', '"' => {
+                const str = try self.scanString();
+                return builder.string(str);
+            },
+            '-', '0'...'9' => {
+                return self.decodeNumber(builder);
+            },
+            else => {
+                const ident = self.scanIdent();
+                if (std.mem.eql(u8, ident, "true")) {
+                    return builder.boolean(true);
+                } else if (std.mem.eql(u8, ident, "false")) {
+                    return builder.boolean(false);
+                }
+                return error.ParseError;
+            },
+        }
+    }
+
+    /// Looks ahead after `{` to determine whether the literal is a table.
+    /// `{}` is an empty table and `{_}` is an empty list.
+    fn isTableBody(self: *Decoder) bool {
+        const save = self.pos;
+        defer self.pos = save;
+        self.skipSpace();
+        if (self.pos >= self.src.len) {
+            return false;
+        }
+        switch (self.src[self.pos]) {
+            '}' => return true,
+            '\'', '"' => {
+                _ = self.scanString() catch return false;
+            },
+            else => {
+                if (self.scanKeyToken().len == 0) {
+                    return false;
+                }
+            },
+        }
+        self.skipSpace();
+        return self.pos < self.src.len and self.src[self.pos] == '=';
+    }
+
+    fn decodeList(self: *Decoder, builder: anytype) !@TypeOf(builder.*).Value {
+        var list = try builder.newList();
+        errdefer builder.abortList(&list);
+
+        self.skipSpace();
+        if (self.consumeEmptyList()) {
+            return builder.endList(&list);
+        }
+        while (true) {
+            self.skipSpace();
+            if (self.pos >= self.src.len) {
+                return error.ParseError;
+            }
+            if (self.src[self.pos] == '}') {
+                self.pos += 1;
+                return builder.endList(&list);
+            }
+            const val = try self.decodeValue(builder);
+            try builder.listAppend(&list, val);
+            try self.consumeSeparator();
+        }
+    }
+
+    fn decodeTable(self: *Decoder, builder: anytype) !@TypeOf(builder.*).Value {
+        var table = try builder.newTable();
+        errdefer builder.abortTable(&table);
+
+        // Quoted keys are copied since decoding the value reuses the scratch buffer.
+        var key_buf: std.ArrayListUnmanaged(u8) = .{};
+        defer key_buf.deinit(self.alloc);
+
+        while (true) {
+            self.skipSpace();
+            if (self.pos >= self.src.len) {
+                return error.ParseError;
+            }
+            if (self.src[self.pos] == '}') {
+                self.pos += 1;
+                return builder.endTable(&table);
+            }
+
+            var key: []const u8 = undefined;
+            const ch = self.src[self.pos];
+            if (ch == '\'' or ch == '"') {
+                const str = try self.scanString();
+                key_buf.clearRetainingCapacity();
+                try key_buf.appendSlice(self.alloc, str);
+                key = key_buf.items;
+            } else {
+                key = self.scanKeyToken();
+                if (key.len == 0) {
+                    return error.ParseError;
+                }
+            }
+
+            self.skipSpace();
+            if (self.pos >= self.src.len or self.src[self.pos] != '=') {
+                return error.ParseError;
+            }
+            self.pos += 1;
+            const val = try self.decodeValue(builder);
+            try builder.tableSet(&table, key, val);
+            try self.consumeSeparator();
+        }
+    }
+
+    fn consumeEmptyList(self: *Decoder) bool {
+        if (self.pos < self.src.len and self.src[self.pos] == '_') {
+            const save = self.pos;
+            self.pos += 1;
+            self.skipSpace();
+            if (self.pos < self.src.len and self.src[self.pos] == '}') {
+                self.pos += 1;
+                return true;
+            }
+            self.pos = save;
+        }
+        return false;
+    }
+
+    /// Entries are separated by a comma or new lines.
+    fn consumeSeparator(self: *Decoder) !void {
+        const start = self.pos;
+        self.skipSpace();
+        if (self.pos >= self.src.len) {
+            return error.ParseError;
+        }
+        if (self.src[self.pos] == ',') {
+            self.pos += 1;
+        } else if (self.src[self.pos] != '}' and std.mem.indexOfScalar(u8, self.src[start..self.pos], '\n') == null) {
+            return error.ParseError;
+        }
+    }
+
+    fn decodeNumber(self: *Decoder, builder: anytype) !@TypeOf(builder.*).Value {
+        const start = self.pos;
+        if (self.src[self.pos] == '-') {
+            self.pos += 1;
+        }
+        const digits_start = self.pos;
+        const is_hex = std.mem.startsWith(u8, self.src[digits_start..], "0x");
+        var is_float = false;
+        while (self.pos < self.src.len) : (self.pos += 1) {
+            switch (self.src[self.pos]) {
+                '0'...'9', 'a'...'d', 'f', 'A'...'F', 'x', 'o', '_' => {},
+                '.' => is_float = true,
+                'e' => {
+                    // Exponent unless it's a hex digit.
+                    if (!is_hex) {
+                        is_float = true;
+                        if (self.pos + 1 < self.src.len and (self.src[self.pos+1] == '-' or self.src[self.pos+1] == '+')) {
+                            self.pos += 1;
+                        }
+                    }
+                },
+                else => break,
+            }
+        }
+        if (is_float) {
+            return builder.float(try std.fmt.parseFloat(f64, self.src[start..self.pos]));
+        }
+
+        var digits = self.src[digits_start..self.pos];
+        var base: u8 = 10;
+        if (digits.len > 2 and digits[0] == '0') {
+            switch (digits[1]) {
+                'x' => base = 16,
+                'o' => base = 8,
+                'b' => base = 2,
+                else => {},
+            }
+            if (base != 10) {
+                digits = digits[2..];
+            }
+        }
+        const mag = std.fmt.parseInt(u64, digits, base) catch return error.ParseError;
+        if (start != digits_start) {
+            // The magnitude of `minInt(i64)` is one more than `maxInt(i64)`.
+            if (mag > @as(u64, std.math.maxInt(i64)) + 1) {
+                return error.ParseError;
+            }
+            return builder.int(@bitCast(0 -% mag));
+        }
+        if (mag > std.math.maxInt(i64)) {
+            return error.ParseError;
+        }
+        return builder.int(@intCast(mag));
+    }
+
+    fn scanIdent(self: *Decoder) []const u8 {
+        const start = self.pos;
+        while (self.pos < self.src.len) : (self.pos += 1) {
+            switch (self.src[self.pos]) {
+                'A'...'Z', 'a'...'z', '0'...'9', '_', '$' => {},
+                else => break,
+            }
+        }
+        return self.src[start..self.pos];
+    }
+
+    /// Keys are identifiers or number literals and are returned as written.
+    fn scanKeyToken(self: *Decoder) []const u8 {
+        const start = self.pos;
+        if (self.pos < self.src.len and self.src[self.pos] == '-') {
+            self.pos += 1;
+        }
+        while (self.pos < self.src.len) : (self.pos += 1) {
+            switch (self.src[self.pos]) {
+                'A'...'Z', 'a'...'z', '0'...'9', '_', '$', '.' => {},
+                else => break,
+            }
+        }
+        return self.src[start..self.pos];
+    }
+
+    /// Returns the string contents. Raw strings are sliced from the source,
+    /// escaped strings are unescaped into the scratch buffer.
+    fn scanString(self: *Decoder) ![]const u8 {
+        const delim = self.src[self.pos];
+        const triple = self.pos + 2 < self.src.len and self.src[self.pos+1] == delim and self.src[self.pos+2] == delim;
+        self.pos += if (triple) 3 else 1;
+        const start = self.pos;
+
+        if (delim == '\'') {
+            if (triple) {
+                const end = std.mem.indexOfPos(u8, self.src, start, "'''") orelse return error.UnterminatedString;
+                self.pos = end + 3;
+                return self.src[start..end];
+            } else {
+                const end = std.mem.indexOfAnyPos(u8, self.src, start, "'\n") orelse return error.UnterminatedString;
+                if (self.src[end] == '\n') {
+                    return error.UnterminatedString;
+                }
+                self.pos = end + 1;
+                return self.src[start..end];
+            }
+        }
+
+        // Find the closing delimiter while skipping over escape sequences.
+        var end = start;
+        var has_escape = false;
+        while (true) {
+            if (end >= self.src.len) {
+                return error.UnterminatedString;
+            }
+            switch (self.src[end]) {
+                '\\' => {
+                    has_escape = true;
+                    end += 2;
+                    continue;
+                },
+                '"' => {
+                    if (!triple) break;
+                    if (end + 2 < self.src.len and self.src[end+1] == '"' and self.src[end+2] == '"') break;
+                },
+                '$' => {
+                    // Template expressions are not data.
+                    if (end + 1 < self.src.len and self.src[end+1] == '(') {
+                        return error.Unsupported;
+                    }
+                },
+                else => {},
+            }
+            end += 1;
+        }
+        self.pos = end + @as(usize, if (triple) 3 else 1);
+        const lit = self.src[start..end];
+        if (!has_escape) {
+            return lit;
+        }
+        try self.buf.resize(self.alloc, lit.len);
+        return cy.unescapeString(self.buf.items, lit, false);
+    }
+
+    /// Skips whitespace and `--` line comments.
+    fn skipSpace(self: *Decoder) void {
+        while (self.pos < self.src.len) {
+            switch (self.src[self.pos]) {
+                ' ', '\t', '\r', '\n' => self.pos += 1,
+                '-' => {
+                    if (self.pos + 1 < self.src.len and self.src[self.pos+1] == '-') {
+                        self.pos = std.mem.indexOfScalarPos(u8, self.src, self.pos, '\n') orelse self.src.len;
+                    } else return;
+                },
+                else => return,
+            }
+        }
+    }
+};
+
+/// Writes CYON incrementally to `Writer` so that large values don't need to be
+/// materialized in memory first. Containers are opened and closed explicitly:
+///
+///     try enc.beginTable();
+///     try enc.key("a");
+///     try enc.int(1);
+///     try enc.endTable();
+pub fn StreamEncoder(comptime Writer: type) type {
+    return struct {
+        writer: Writer,
+        depth: u32 = 0,
+
+        /// Whether the innermost container has no entries yet.
+        empty: bool = false,
+
+        /// Whether a key was just written and its value follows on the same line.
+        after_key: bool = false,
+
+        const Self = @This();
+
+        pub fn init(writer: Writer) Self {
+            return .{ .writer = writer };
+        }
+
+        fn indent(self: *Self) !void {
+            try self.writer.writeByteNTimes(' ', self.depth * 4);
+        }
+
+        fn beginEntry(self: *Self) !void {
+            if (self.after_key) {
+                self.after_key = false;
+                return;
+            }
+            if (self.depth > 0) {
+                if (self.empty) {
+                    try self.writer.writeByte('\n');
+                    self.empty = false;
+                }
+                try self.indent();
+            }
+        }
+
+        fn endEntry(self: *Self) !void {
+            if (self.depth > 0) {
+                try self.writer.writeAll(",\n");
+            }
+        }
+
+        pub fn beginList(self: *Self) !void {
+            try self.beginEntry();
+            try self.writer.writeByte('{');
+            self.depth += 1;
+            self.empty = true;
+        }
+
+        pub fn endList(self: *Self) !void {
+            try self.endContainer("_}");
+        }
+
+        pub fn beginTable(self: *Self) !void {
+            try self.beginList();
+        }
+
+        pub fn endTable(self: *Self) !void {
+            try self.endContainer("}");
+        }
+
+        fn endContainer(self: *Self, empty_close: []const u8) !void {
+            self.depth -= 1;
+            if (self.empty) {
+                try self.writer.writeAll(empty_close);
+            } else {
+                try self.indent();
+                try self.writer.writeByte('}');
+            }
+            // The parent now has at least this entry.
+            self.empty = false;
+            try self.endEntry();
+        }
+
+        /// Writes a table key. Keys that aren't identifiers or integers are quoted.
+        pub fn key(self: *Self, k: []const u8) !void {
+            try self.beginEntry();
+            if (isPlainKey(k)) {
+                try self.writer.writeAll(k);
+            } else {
+                try writeString(self.writer, k);
+            }
+            try self.writer.writeAll(" = ");
+            self.after_key = true;
+        }
+
+        pub fn string(self: *Self, str: []const u8) !void {
+            try self.beginEntry();
+            try writeString(self.writer, str);
+            try self.endEntry();
+        }
+
+        pub fn int(self: *Self, i: i64) !void {
+            try self.beginEntry();
+            try Common.encodeInt(self.writer, i);
+            try self.endEntry();
+        }
+
+        pub fn float(self: *Self, f: f64) !void {
+            try self.beginEntry();
+            try Common.encodeFloat(self.writer, f);
+            try self.endEntry();
+        }
+
+        pub fn boolean(self: *Self, b: bool) !void {
+            try self.beginEntry();
+            try Common.encodeBool(self.writer, b);
+            try self.endEntry();
+        }
+    };
+}
+
+fn isPlainKey(k: []const u8) bool {
+    if (k.len == 0) {
+        return false;
+    }
+    if (k[0] >= '0' and k[0] <= '9') {
+        for (k) |ch| {
+            if (ch < '0' or ch > '9') return false;
+        }
+        return true;
+    }
+    for (k) |ch| {
+        switch (ch) {
+            'A'...'Z', 'a'...'z', '0'...'9', '_' => {},
+            else => return false,
+        }
+    }
+    return true;
+}
+
+/// Prefers a raw string. Otherwise, writes an escaped literal that both the parser
+/// and `Decoder` read back to the same bytes.
+fn writeString(writer: anytype, str: []const u8) !void {
+    if (std.mem.indexOfAny(u8, str, "'\n\r") == null) {
+        try writer.writeByte('\'');
+        try writer.writeAll(str);
+        try writer.writeByte('\'');
+        return;
+    }
+    try writer.writeByte('"');
+    var start: usize = 0;
+    for (str, 0..) |ch, i| {
+        const esc: []const u8 = switch (ch) {
+            '"' => "\\\"",
+            '\\' => "\\\\",
+            '\n' => "\\n",
+            '\r' => "\\r",
+            '\t' => "\\t",
+            // Avoid starting a template expression.
+            '$' => "\\x24",
+            else => continue,
+        };
+        try writer.writeAll(str[start..i]);
+        try writer.writeAll(esc);
+        start = i + 1;
+    }
+    try writer.writeAll(str[start..]);
+    try writer.writeByte('"');
+}
+
 const TestRoot = struct {
     name: []const u8,
     list: []const TestListItem,
@@ -797,6 +1313,161 @@ test "decodeTable" {
     try t.eqStr(root.table[4].val, "bar `bar`\nbar");
 }
 
+const TestBuilder = struct {
+    arena: std.mem.Allocator,
+
+    const Value = union(enum) {
+        list: []const Value,
+        table: []const Entry,
+        string: []const u8,
+        int: i64,
+        float: f64,
+        bool: bool,
+    };
+    const Entry = struct {
+        key: []const u8,
+        val: Value,
+    };
+    const List = std.ArrayListUnmanaged(Value);
+    const Table = std.ArrayListUnmanaged(Entry);
+
+    fn newList(_: *TestBuilder) !List {
+        return .{};
+    }
+    fn listAppend(self: *TestBuilder, list: *List, val: Value) !void {
+        try list.append(self.arena, val);
+    }
+    fn endList(_: *TestBuilder, list: *List) !Value {
+        return .{ .list = list.items };
+    }
+    fn abortList(_: *TestBuilder, _: *List) void {}
+    fn newTable(_: *TestBuilder) !Table {
+        return .{};
+    }
+    fn tableSet(self: *TestBuilder, table: *Table, key: []const u8, val: Value) !void {
+        try table.append(self.arena, .{ .key = try self.arena.dupe(u8, key), .val = val });
+    }
+    fn endTable(_: *TestBuilder, table: *Table) !Value {
+        return .{ .table = table.items };
+    }
+    fn abortTable(_: *TestBuilder, _: *Table) void {}
+    fn string(self: *TestBuilder, str: []const u8) !Value {
+        return .{ .string = try self.arena.dupe(u8, str) };
+    }
+    fn int(_: *TestBuilder, i: i64) !Value {
+        return .{ .int = i };
+    }
+    fn float(_: *TestBuilder, f: f64) !Value {
+        return .{ .float = f };
+    }
+    fn boolean(_: *TestBuilder, b: bool) !Value {
+        return .{ .bool = b };
+    }
+    fn release(_: *TestBuilder, _: Value) void {}
+};
+
+test "Decoder" {
+    var arena = std.heap.ArenaAllocator.init(t.alloc);
+    defer arena.deinit();
+    var builder = TestBuilder{ .arena = arena.allocator() };
+
+    var dec = Decoder.init(t.alloc,
+        \\-- Comment.
+        \\{
+        \\    name = 'project',
+        \\    list = {1, -2, 0x10, 1.5e2}
+        \\    empty_list = {_},
+        \\    empty_table = {},
+        \\    'a b' = "x\ny",
+        \\    10 = true,
+        \\}
+    );
+    defer dec.deinit();
+    const root = try dec.decode(&builder);
+    const entries = root.table;
+    try t.eq(entries.len, 6);
+    try t.eqStr(entries[0].key, "name");
+    try t.eqStr(entries[0].val.string, "project");
+    try t.eq(entries[1].val.list.len, 4);
+    try t.eq(entries[1].val.list[0].int, 1);
+    try t.eq(entries[1].val.list[1].int, -2);
+    try t.eq(entries[1].val.list[2].int, 16);
+    try t.eq(entries[1].val.list[3].float, 150);
+    try t.eq(entries[2].val.list.len, 0);
+    try t.eq(entries[3].val.table.len, 0);
+    try t.eqStr(entries[4].key, "a b");
+    try t.eqStr(entries[4].val.string, "x\ny");
+    try t.eqStr(entries[5].key, "10");
+    try t.eq(entries[5].val.bool, true);
+
+    var bad = Decoder.init(t.alloc, "{a = 1 b = 2}");
+    defer bad.deinit();
+    try t.expectError(bad.decode(&builder), error.ParseError);
+
+    var min = Decoder.init(t.alloc, "{-9223372036854775808, 9223372036854775807}");
+    defer min.deinit();
+    const ints = (try min.decode(&builder)).list;
+    try t.eq(ints[0].int, std.math.minInt(i64));
+    try t.eq(ints[1].int, std.math.maxInt(i64));
+
+    var overflow = Decoder.init(t.alloc, "9223372036854775808");
+    defer overflow.deinit();
+    try t.expectError(overflow.decode(&builder), error.ParseError);
+
+    var neg_overflow = Decoder.init(t.alloc, "-9223372036854775809");
+    defer neg_overflow.deinit();
+    try t.expectError(neg_overflow.decode(&builder), error.ParseError);
+
+    var hex_overflow = Decoder.init(t.alloc, "0xffffffffffffffff");
+    defer hex_overflow.deinit();
+    try t.expectError(hex_overflow.decode(&builder), error.ParseError);
+}
+
+test "StreamEncoder" {
+    var buf: std.ArrayListUnmanaged(u8) = .{};
+    defer buf.deinit(t.alloc);
+    var enc = StreamEncoder(std.ArrayListUnmanaged(u8).Writer).init(buf.writer(t.alloc));
+    try enc.beginTable();
+    try enc.key("name");
+    try enc.string("it's");
+    try enc.key("list");
+    try enc.beginList();
+    try enc.int(1);
+    try enc.float(2);
+    try enc.beginList();
+    try enc.endList();
+    try enc.endList();
+    try enc.key("a b");
+    try enc.beginTable();
+    try enc.endTable();
+    try enc.key("s");
+    try enc.string("$(x)\n");
+    try enc.endTable();
+    try t.eqStr(buf.items,
+        \\{
+        \\    name = "it's",
+        \\    list = {
+        \\        1,
+        \\        2.0,
+        \\        {_},
+        \\    },
+        \\    'a b' = {},
+        \\    s = "\x24(x)\n",
+        \\}
+    );
+
+    // Round trip.
+    var arena = std.heap.ArenaAllocator.init(t.alloc);
+    defer arena.deinit();
+    var builder = TestBuilder{ .arena = arena.allocator() };
+    var dec = Decoder.init(t.alloc, buf.items);
+    defer dec.deinit();
+    const root = try dec.decode(&builder);
+    try t.eqStr(root.table[0].val.string, "it's");
+    try t.eq(root.table[1].val.list[2].list.len, 0);
+    try t.eqStr(root.table[3].val.string, "$(x)\n");
+}
+
 // Same as std.mem.replace except we write to an ArrayList.
 pub fn replaceIntoList(comptime T: type, input: []const T, needle: []const T, replacement: []const T, output: *std.ArrayList(T)) usize {
     // Clear the array list.
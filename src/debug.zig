@@ -38,7 +38,6 @@ pub fn countNewLines(str: []const u8, outLastIdx: *u32) u32 {
     return count;
 }
 
-/// TODO: Memoize this function.
 pub fn getDebugSymByPc(vm: *const cy.VM, pc: usize) ?cy.DebugSym {
     return getDebugSymFromTable(vm.debugTable, pc);
 }
@@ -67,12 +66,22 @@ pub fn getIndexOfDebugSym(vm: *const cy.VM, pc: usize) ?usize {
     return indexOfDebugSymFromTable(vm.debugTable, pc);
 }
 
+/// Debug syms are appended as insts are emitted, so the table is ordered by pc.
+/// Returns the first sym at `pc`.
 pub fn indexOfDebugSymFromTable(table: []const cy.DebugSym, pc: usize) ?usize {
-    for (table, 0..) |sym, i| {
-        if (sym.pc == pc) {
-            return i;
+    var low: usize = 0;
+    var high: usize = table.len;
+    while (low < high) {
+        const mid = low + (high - low) / 2;
+        if (table[mid].pc < pc) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
+    if (low < table.len and table[low].pc == pc) {
+        return low;
+    }
     return null;
 }
 
@@ -331,6 +340,21 @@ test "debug internals." {
     try t.eq(@sizeOf(vmc.CompactFrame), 8);
 }
 
+test "Debug sym lookup by pc." {
+    const S = struct {
+        fn sym(pc: u32) cy.DebugSym {
+            return .{ .pc = pc, .loc = 0, .frameLoc = 0, .file = 0 };
+        }
+    };
+    const table = [_]cy.DebugSym{ S.sym(0), S.sym(4), S.sym(4), S.sym(9), S.sym(20) };
+    try t.eq(indexOfDebugSymFromTable(&table, 0), 0);
+    try t.eq(indexOfDebugSymFromTable(&table, 4), 1);
+    try t.eq(indexOfDebugSymFromTable(&table, 20), 4);
+    try t.eq(indexOfDebugSymFromTable(&table, 5), null);
+    try t.eq(indexOfDebugSymFromTable(&table, 21), null);
+    try t.eq(indexOfDebugSymFromTable(&.{}, 0), null);
+}
+
 /// Can only rely on pc and other non-reference values to build the stack frame since
 /// unwinding could have already freed reference values.
 pub fn compactToStackFrame(vm: *cy.VM, stack: []const cy.Value, frame: vmc.CompactFrame) !StackFrame {
@@ -34,9 +34,133 @@ test "fiber internals." {
     }
 }
 
+test "Fiber stack size classes." {
+    var vm: cy.VM = undefined;
+    try vm.init(t.alloc);
+    defer vm.deinit(false);
+
+    if (UseStackFreeLists) {
+        try t.eq(stackSizeClass(1), 0);
+        try t.eq(stackSizeClass(33), 1);
+        try t.eq(stackSizeClass(1025), null);
+
+        // Freed stacks are reused by any length in the same class.
+        const stack = try allocStack(&vm, 20);
+        try t.eq(stack.len, 32);
+        freeStack(&vm, stack);
+        try t.eq(vm.fiberStackFreeLists[0].len, 1);
+        const stack2 = try allocStack(&vm, 30);
+        try t.eq(stack2.ptr, stack.ptr);
+        try t.eq(vm.fiberStackFreeLists[0].len, 0);
+
+        // Stacks that grew past their class length go back to the allocator.
+        const grown = try vm.alloc.realloc(stack2, 40);
+        freeStack(&vm, grown);
+        try t.eq(vm.fiberStackFreeLists[0].len, 0);
+        try t.eq(vm.fiberStackFreeLists[1].len, 0);
+    }
+}
+
+/// Fiber stack lengths (in values) that are recycled through per-class free lists
+/// instead of going back to the allocator.
+pub const StackSizeClasses = [_]u32{ 32, 64, 128, 256, 512, 1024 };
+
+/// Max stacks held by each size class.
+pub const MaxFreeStacks = 64;
+
+/// Disabled in trace mode so that use-after-free is surfaced by the allocator.
+const UseStackFreeLists = !cy.Trace;
+
+pub const StackFreeList = struct {
+    /// The first value of a free stack holds the next free stack.
+    head: ?[*]Value,
+    len: u32,
+};
+
+fn stackSizeClass(len: usize) ?u8 {
+    inline for (StackSizeClasses, 0..) |class_len, i| {
+        if (len <= class_len) {
+            return i;
+        }
+    }
+    return null;
+}
+
+fn allocStack(vm: *cy.VM, len: usize) ![]Value {
+    if (UseStackFreeLists) {
+        if (stackSizeClass(len)) |class| {
+            const list = &vm.fiberStackFreeLists[class];
+            if (list.head) |stack| {
+                list.head = @as(*?[*]Value, @ptrCast(stack)).*;
+                list.len -= 1;
+                return stack[0..StackSizeClasses[class]];
+            }
+            return vm.alloc.alloc(Value, StackSizeClasses[class]);
+        }
+    }
+    return vm.alloc.alloc(Value, len);
+}
+
+/// Only stacks that still have their class length are recycled.
+/// Stacks that grew are returned to the allocator.
+fn freeStack(vm: *cy.VM, stack: []Value) void {
+    if (UseStackFreeLists) {
+        if (stackSizeClass(stack.len)) |class| {
+            const list = &vm.fiberStackFreeLists[class];
+            if (StackSizeClasses[class] == stack.len and list.len < MaxFreeStacks) {
+                @as(*?[*]Value, @ptrCast(stack.ptr)).* = list.head;
+                list.head = stack.ptr;
+                list.len += 1;
+                return;
+            }
+        }
+    }
+    vm.alloc.free(stack);
+}
+
+pub fn deinitStackFreeLists(vm: *cy.VM) void {
+    for (&vm.fiberStackFreeLists, StackSizeClasses) |*list, class_len| {
+        var next = list.head;
+        while (next) |stack| {
+            next = @as(*?[*]Value, @ptrCast(stack)).*;
+            vm.alloc.free(stack[0..class_len]);
+        }
+        list.* = .{ .head = null, .len = 0 };
+    }
+}
+
+/// Length of the stack that a fiber with the compiler's `stack_size` starts with.
+fn initialStackLen(stack_size: usize) usize {
+    if (UseStackFreeLists) {
+        if (stackSizeClass(stack_size)) |class| {
+            return StackSizeClasses[class];
+        }
+    }
+    return stack_size;
+}
+
+/// Remembers the stack length that a fiber grew to so that later fibers
+/// from the same entry pc start with it instead of growing again.
+fn recordStackLen(vm: *cy.VM, fiber: *const cy.Fiber) void {
+    if (fiber.initialPcOffset == cy.NullId or fiber.stackLen <= initialStackLen(fiber.stack_size)) {
+        return;
+    }
+    const res = vm.fiberStackLens.getOrPut(vm.alloc, fiber.initialPcOffset) catch return;
+    if (!res.found_existing or res.value_ptr.* < fiber.stackLen) {
+        res.value_ptr.* = fiber.stackLen;
+    }
+}
+
 pub fn allocFiber(vm: *cy.VM, pc: usize, args: []const cy.Value, argDst: u8, initialStackSize: u32) !cy.Value {
+    var stack_len: usize = initialStackSize;
+    if (vm.fiberStackLens.count() > 0 and pc != cy.NullId) {
+        if (vm.fiberStackLens.get(@intCast(pc))) |len| {
+            stack_len = @max(stack_len, len);
+        }
+    }
+
     // Args are copied over to the new stack.
-    var stack = try vm.alloc.alloc(Value, initialStackSize);
+    var stack = try allocStack(vm, stack_len);
     // Assumes initial stack size generated by compiler is enough to hold captured args.
     @memcpy(stack[argDst..argDst+args.len], args);
 
@@ -173,7 +297,8 @@ pub fn releaseFiberStack(vm: *cy.VM, fiber: *cy.Fiber) !void {
     }
 
     // Finally free stack.
-    vm.alloc.free(stack);
+    recordStackLen(vm, fiber);
+    freeStack(vm, stack);
 }
 
 // Determine whether it's a vm or host frame.
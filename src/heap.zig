@@ -15,6 +15,7 @@ const t = stdx.testing;
 const std = @import("std");
 const builtin = @import("builtin");
 const tcc = @import("tcc");
+const os_ffi = @import("std/os_ffi.zig");
 const log = cy.log.scoped(.heap);
 const NullId = std.math.maxInt(u32);
 const NullU8 = std.math.maxInt(u8);
@@ -260,6 +261,62 @@ pub const ListInner = extern struct {
     }
 };
 
+pub const ListValueElem = enum(u8) {
+    /// Unboxed primitive, one slot per element.
+    unboxed,
+    /// Boxed value, one slot per element. The list holds a reference.
+    boxed,
+    /// Struct without boxed fields. Fields are copied inline with a stride of `nfields`.
+    struct_t,
+};
+
+/// Backing storage for `ListValue[T]`. Unlike `ListInner`, struct elements are stored
+/// inline so that iterating over the list does not chase a heap object per element.
+pub const ListValueInner = extern struct {
+    ptr: [*]Value,
+    /// Capacity in elements.
+    cap: usize,
+    /// Length in elements.
+    len: usize,
+    /// Number of `Value` slots per element.
+    stride: u32,
+    elem: ListValueElem,
+
+    pub inline fn elemPtr(self: *ListValueInner, idx: usize) [*]Value {
+        return self.ptr + idx * self.stride;
+    }
+
+    /// Returns every slot in use.
+    pub inline fn slots(self: *ListValueInner) []Value {
+        return self.ptr[0..self.len * self.stride];
+    }
+
+    pub fn growTotalCapacity(self: *ListValueInner, alloc: std.mem.Allocator, min_cap: usize) !void {
+        if (min_cap <= self.cap) {
+            return;
+        }
+        var new_cap = self.cap;
+        while (new_cap < min_cap) {
+            new_cap +|= new_cap / 2 + 8;
+        }
+        const new_slots = new_cap * self.stride;
+        if (self.cap == 0) {
+            const buf = try alloc.alloc(Value, new_slots);
+            self.ptr = buf.ptr;
+        } else {
+            const buf = try alloc.realloc(self.ptr[0..self.cap * self.stride], new_slots);
+            self.ptr = buf.ptr;
+        }
+        self.cap = new_cap;
+    }
+
+    pub fn deinit(self: *ListValueInner, alloc: std.mem.Allocator) void {
+        if (self.cap > 0) {
+            alloc.free(self.ptr[0..self.cap * self.stride]);
+        }
+    }
+};
+
 pub const List = extern struct {
     typeId: cy.TypeId,
     rc: u32,
@@ -429,11 +486,44 @@ pub const String = extern struct {
         return (self.headerAndLen & 0x40000000) > 0;
     }
 
+    /// Whether this object is the entry in `vm.strInterns`.
+    pub fn isInterned(self: *const String) bool {
+        return (self.headerAndLen & StringFlagBit) > 0 and self.len() <= DefaultStringInternMaxByteLen;
+    }
+
+    /// Whether this object was allocated with `growableStringCap` bytes so that it can be appended to in place.
+    pub fn isGrowable(self: *const String) bool {
+        return (self.headerAndLen & StringFlagBit) > 0 and self.len() > DefaultStringInternMaxByteLen;
+    }
+
+    /// Byte capacity of an `astring` or `ustring`.
+    pub fn bufCap(self: *const String) usize {
+        if (self.isGrowable()) {
+            return growableStringCap(self.len());
+        }
+        return self.len();
+    }
+
     pub fn len(self: *const String) u32 {
-        return self.headerAndLen & 0x3fffffff;
+        return self.headerAndLen & MaxStringByteLen;
     }
 };
 
+/// The length shares `headerAndLen` with the string type and `StringFlagBit`.
+/// Allocating a longer string returns `error.StringTooLong`.
+pub const MaxStringByteLen: u32 = 0x1fffffff;
+
+/// Marks an interned string if the length is at most `DefaultStringInternMaxByteLen`,
+/// or a growable string if the length is larger. Interned strings are never appended to
+/// in place, so the two meanings can share one bit.
+const StringFlagBit: u32 = 0x20000000;
+
+/// Growable strings round their capacity up to a power of two, so the capacity
+/// can be derived from the length and does not need to be stored.
+fn growableStringCap(len: usize) usize {
+    return std.math.ceilPowerOfTwoAssert(usize, len);
+}
+
 /// 28 byte length can fit inside a Heap pool object.
 pub const MaxPoolObjectAstringByteLen = 28;
 
@@ -509,16 +599,19 @@ pub const Trait = extern struct {
     typeId: cy.TypeId align(8),
     rc: u32,
     impl: Value,
-    vtable: u32,
+
+    /// Points into `VMC.vtables` so that a trait call only needs one dependent load.
+    vtable: [*]const rt.FuncSymbol,
 };
 
+/// The `Trait` op allocates inline in vm.c. This is used for traits created by the host.
 fn allocTrait(vm: *cy.VM, type_id: cy.TypeId, vtable: u16, impl: cy.Value) !cy.Value {
     const obj = try allocPoolObject(vm);
     obj.trait = .{
         .typeId = type_id | vmc.CYC_TYPE_MASK,
         .rc = 1,
         .impl = impl,
-        .vtable = vtable,
+        .vtable = vm.c.getVtables().buf[vtable].ptr,
     };
     return Value.initCycPtr(obj);
 }
@@ -611,6 +704,28 @@ pub fn allocFuture(vm: *cy.VM, type_id: cy.TypeId) !Value {
     }
 }
 
+pub fn allocListValue(vm: *cy.VM, type_id: cy.TypeId, elem: ListValueElem, stride: u32) !Value {
+    const cyclable = vm.c.types[type_id].cyclable;
+    var new: *ListValueInner = undefined;
+    if (cyclable) {
+        new = @ptrCast(try allocHostCycObject(vm, type_id, @sizeOf(ListValueInner)));
+    } else {
+        new = @ptrCast(try allocHostNoCycObject(vm, type_id, @sizeOf(ListValueInner)));
+    }
+    new.* = .{
+        .ptr = undefined,
+        .cap = 0,
+        .len = 0,
+        .stride = stride,
+        .elem = elem,
+    };
+    if (cyclable) {
+        return Value.initHostCycPtr(new);
+    } else {
+        return Value.initHostNoCycPtr(new);
+    }
+}
+
 pub fn allocFutureResolver(vm: *cy.VM, type_id: cy.TypeId, future: Value) !Value {
     const cyclable = vm.c.types[type_id].cyclable;
     var new: *FutureResolver = undefined;
@@ -714,9 +829,14 @@ pub const FuncSym = extern struct {
 const TccState = extern struct {
     typeId: cy.TypeId align(8),
     rc: u32,
-    state: *tcc.TCCState,
-    lib: *std.DynLib,
-    hasDynLib: bool,
+    /// Null when the compiled code was loaded from a cached shim library
+    /// or when every binded function uses a trampoline.
+    state: ?*tcc.TCCState,
+    lib: ?*std.DynLib,
+    /// Cached shim library.
+    shim: ?*std.DynLib,
+    /// Direct-call trampolines.
+    trampolines: ?*os_ffi.Trampolines,
 };
 
 pub const Pointer = extern struct {
@@ -805,6 +925,83 @@ pub const DListNode = extern struct {
     }
 };
 
+/// Block sizes (including the external object header) that are recycled through
+/// per-class free lists instead of going back to the allocator.
+/// Covers medium objects that don't fit in a pool slot: objects with more than 4 fields,
+/// strings over the pool string lengths, closures and tuples.
+pub const ExternalSizeClasses = [_]u32{ 64, 96, 128, 192, 256 };
+
+/// Max blocks held by each size class.
+pub const MaxExternalFreeBlocks = 128;
+
+/// Disabled in trace mode so that use-after-free is surfaced by the allocator.
+const UseExternalFreeLists = !cy.Trace;
+
+const ExternalFreeBlock = struct {
+    next: ?*ExternalFreeBlock,
+};
+
+pub const ExternalFreeList = struct {
+    head: ?*ExternalFreeBlock,
+    len: u32,
+};
+
+fn externalSizeClass(size: usize) ?u8 {
+    inline for (ExternalSizeClasses, 0..) |class_size, i| {
+        if (size <= class_size) {
+            return i;
+        }
+    }
+    return null;
+}
+
+fn allocExternalBlock(vm: *cy.VM, size: usize) ![]align(@alignOf(HeapObject)) u8 {
+    if (UseExternalFreeLists) {
+        if (externalSizeClass(size)) |class| {
+            const list = &vm.externalFreeLists[class];
+            if (list.head) |block| {
+                list.head = block.next;
+                list.len -= 1;
+                return @as([*]align(@alignOf(HeapObject)) u8, @ptrCast(block))[0..ExternalSizeClasses[class]];
+            }
+            return vm.alloc.alignedAlloc(u8, @alignOf(HeapObject), ExternalSizeClasses[class]);
+        }
+    }
+    return vm.alloc.alignedAlloc(u8, @alignOf(HeapObject), size);
+}
+
+/// `size` can be understated when the allocator doesn't need it (host objects with libc malloc pass 1).
+/// The block then lands in a class that is no larger than the real block.
+fn freeExternalBlock(vm: *cy.VM, ptr: [*]align(@alignOf(HeapObject)) u8, size: usize) void {
+    if (UseExternalFreeLists) {
+        if (externalSizeClass(size)) |class| {
+            const list = &vm.externalFreeLists[class];
+            if (list.len < MaxExternalFreeBlocks) {
+                const block: *ExternalFreeBlock = @ptrCast(ptr);
+                block.next = list.head;
+                list.head = block;
+                list.len += 1;
+            } else {
+                vm.alloc.free(ptr[0..ExternalSizeClasses[class]]);
+            }
+            return;
+        }
+    }
+    vm.alloc.free(ptr[0..size]);
+}
+
+pub fn deinitExternalFreeLists(vm: *cy.VM) void {
+    for (&vm.externalFreeLists, ExternalSizeClasses) |*list, class_size| {
+        var next = list.head;
+        while (next) |block| {
+            next = block.next;
+            const ptr: [*]align(@alignOf(HeapObject)) u8 = @ptrCast(block);
+            vm.alloc.free(ptr[0..class_size]);
+        }
+        list.* = .{ .head = null, .len = 0 };
+    }
+}
+
 pub fn allocExternalObject(vm: *cy.VM, size: usize, comptime cyclable: bool) !*HeapObject {
     // Align with HeapObject so it can be casted.
     const addToCyclableList = comptime (cy.hasGC and cyclable);
@@ -814,7 +1011,7 @@ pub fn allocExternalObject(vm: *cy.VM, size: usize, comptime cyclable: bool) !*H
     const ZigLenSize = if (cy.Malloc == .zig) @sizeOf(u64) else 0;
     const PayloadSize = (if (addToCyclableList) @sizeOf(DListNode) else 0) + ZigLenSize;
 
-    const slice = try vm.alloc.alignedAlloc(u8, @alignOf(HeapObject), size + PayloadSize);
+    const slice = try allocExternalBlock(vm, size + PayloadSize);
     defer {
         if (cy.Trace) {
             cy.heap.traceAlloc(vm, @ptrCast(slice.ptr + PayloadSize));
@@ -832,6 +1029,7 @@ pub fn allocExternalObject(vm: *cy.VM, size: usize, comptime cyclable: bool) !*H
     if (cy.Malloc == .zig) {
         @as(*u64, @ptrCast(slice.ptr + PayloadSize - ZigLenSize)).* = size;
     }
+    vm.numExternalObjects += 1;
     cy.arc.log.tracevIf(log_mem, "0 +1 alloc external object: {*}", .{slice.ptr + PayloadSize});
     if (cy.TrackGlobalRC) {
         vm.c.refCounts += 1;
@@ -843,8 +1041,8 @@ pub fn allocExternalObject(vm: *cy.VM, size: usize, comptime cyclable: bool) !*H
     return @ptrCast(slice.ptr + PayloadSize);
 }
 
-/// Assumes new object will have an RC = 1.
-pub fn allocPoolObject(self: *cy.VM) !*HeapObject {
+/// Detaches the head free span as the current bump span, growing the heap if there are no free spans.
+fn refillBumpSpan(self: *cy.VM) !void {
     if (self.heapFreeHead == null) {
         const list = try growHeapPages(self, @max(1, (self.heapPages.len * 15) / 10));
         self.heapFreeHead = list.head;
@@ -852,41 +1050,176 @@ pub fn allocPoolObject(self: *cy.VM) !*HeapObject {
             self.heapFreeTail = list.tail;
         }
     }
-    const ptr = self.heapFreeHead.?;
-    defer {
-        if (cy.Trace) {
-            traceAlloc(self, ptr);
-            if (self.heapFreeTail == ptr) {
-                // Ensure tail is updated if it was the same segment as head.
-                self.heapFreeTail = self.heapFreeHead;
+    const span = self.heapFreeHead.?;
+    self.heapFreeHead = span.freeSpan.next;
+    if (cy.Trace and self.heapFreeHead == null) {
+        self.heapFreeTail = null;
+    }
+    const objects: [*]HeapObject = @ptrCast(span);
+    self.heapBumpPtr = objects;
+    self.heapBumpEnd = objects + span.freeSpan.len;
+}
+
+/// Position of the bump span after a flush. No pool object sits right below it, so
+/// `freePoolObject` can't rewind into slots that were already returned to the free list,
+/// and it never points into a page that `rebuildFreeSpans` releases.
+var DetachedBumpSpan: [1]HeapObject = undefined;
+
+/// Returns the unallocated rest of the bump span to the free list as a regular free span.
+/// Must be called before walking heap pages since the bump span has no valid span header.
+/// The next allocation detaches a new bump span from the free list.
+pub fn flushBumpSpan(self: *cy.VM) void {
+    if (self.heapBumpPtr != self.heapBumpEnd) {
+        const first = &self.heapBumpPtr[0];
+        first.freeSpan = .{
+            .typeId = NullId,
+            .len = @intCast(self.heapBumpEnd - self.heapBumpPtr),
+            .start = first,
+            .next = self.heapFreeHead,
+        };
+        (self.heapBumpEnd - 1)[0].freeSpan.start = first;
+        self.heapFreeHead = first;
+        if (cy.Trace and self.heapFreeTail == null) {
+            self.heapFreeTail = first;
+        }
+    }
+    self.heapBumpPtr = &DetachedBumpSpan;
+    self.heapBumpEnd = self.heapBumpPtr;
+}
+
+inline fn isInBumpSpan(self: *const cy.VM, obj: *const HeapObject) bool {
+    return @intFromPtr(obj) >= @intFromPtr(self.heapBumpPtr) and @intFromPtr(obj) < @intFromPtr(self.heapBumpEnd);
+}
+
+/// Default number of pages kept by `rebuildFreeSpans` even if they are fully free.
+pub const DefaultMinHeapPages = 4;
+
+/// Rebuilds the free list from the free slots in each page.
+/// Adjacent free spans left behind by `freePoolObject` are coalesced and spans are linked
+/// in address order so that subsequent bump allocations stay page-local.
+/// Fully free pages beyond `vm.heapMinPages` are released to the allocator.
+pub fn rebuildFreeSpans(self: *cy.VM) void {
+    // The bump span is detached so that it can't point into a released page.
+    flushBumpSpan(self);
+
+    var head: ?*HeapObject = null;
+    var tail: ?*HeapObject = null;
+    const pages = self.heapPages.items();
+    var num_pages: usize = 0;
+    var num_released: usize = 0;
+    for (pages) |page| {
+        if (pages.len - num_released > self.heapMinPages and isHeapPageFree(page)) {
+            self.alloc.destroy(page);
+            num_released += 1;
+            continue;
+        }
+        self.heapPages.buf[num_pages] = page;
+        num_pages += 1;
+
+        var i: u32 = 1;
+        while (i < page.objects.len) {
+            if (page.objects[i].freeSpan.typeId != NullId) {
+                i += 1;
+                continue;
+            }
+            const start = i;
+            i += 1;
+            while (i < page.objects.len and page.objects[i].freeSpan.typeId == NullId) {
+                i += 1;
+            }
+            const first = &page.objects[start];
+            first.freeSpan = .{
+                .typeId = NullId,
+                .len = i - start,
+                .start = first,
+                .next = null,
+            };
+            page.objects[i-1].freeSpan.start = first;
+            if (tail) |tail_| {
+                tail_.freeSpan.next = first;
+            } else {
+                head = first;
             }
+            tail = first;
         }
-        cy.arc.log.tracevIf(log_mem, "0 +1 alloc pool object: {*}", .{ptr});
-        if (cy.TrackGlobalRC) {
-            self.c.refCounts += 1;
+    }
+    self.heapPages.len = num_pages;
+    self.heapFreeHead = head;
+    if (cy.Trace) {
+        self.heapFreeTail = tail;
+    }
+}
+
+fn isHeapPageFree(page: *const HeapPage) bool {
+    for (page.objects[1..]) |obj| {
+        if (obj.freeSpan.typeId != NullId) {
+            return false;
         }
-        if (cy.Trace) {
-            self.c.trace.numRetains += 1;
-            self.c.trace.numRetainAttempts += 1;
+    }
+    return true;
+}
+
+pub const HeapStats = struct {
+    pages: usize,
+    live_objects: usize,
+    free_slots: usize,
+    free_spans: usize,
+    largest_free_span: usize,
+    external_objects: usize,
+    external_cached_bytes: usize,
+};
+
+pub fn getHeapStats(self: *cy.VM) HeapStats {
+    flushBumpSpan(self);
+    var res = HeapStats{
+        .pages = self.heapPages.len,
+        .live_objects = 0,
+        .free_slots = 0,
+        .free_spans = 0,
+        .largest_free_span = 0,
+        .external_objects = self.numExternalObjects,
+        .external_cached_bytes = 0,
+    };
+    for (self.heapPages.items()) |page| {
+        var i: u32 = 1;
+        while (i < page.objects.len) {
+            const obj = &page.objects[i];
+            if (obj.freeSpan.typeId != NullId) {
+                res.live_objects += 1;
+                i += 1;
+            } else {
+                res.free_slots += obj.freeSpan.len;
+                res.free_spans += 1;
+                res.largest_free_span = @max(res.largest_free_span, obj.freeSpan.len);
+                i += obj.freeSpan.len;
+            }
         }
     }
-    if (ptr.freeSpan.len == 1) {
-        // This is the only free slot, move to the next free span.
-        self.heapFreeHead = ptr.freeSpan.next;
-        return ptr;
-    } else {
-        const next = &@as([*]HeapObject, @ptrCast(ptr))[1];
-        next.freeSpan = .{
-            .typeId = NullId,
-            .len = ptr.freeSpan.len - 1,
-            .start = next,
-            .next = ptr.freeSpan.next,
-        };
-        const last = &@as([*]HeapObject, @ptrCast(ptr))[ptr.freeSpan.len-1];
-        last.freeSpan.start = next;
-        self.heapFreeHead = next;
-        return ptr;
+    for (self.externalFreeLists, ExternalSizeClasses) |list, class_size| {
+        res.external_cached_bytes += list.len * class_size;
+    }
+    return res;
+}
+
+/// Assumes new object will have an RC = 1.
+pub fn allocPoolObject(self: *cy.VM) !*HeapObject {
+    if (self.heapBumpPtr == self.heapBumpEnd) {
+        try refillBumpSpan(self);
+    }
+    const ptr = &self.heapBumpPtr[0];
+    self.heapBumpPtr += 1;
+    if (cy.Trace) {
+        traceAlloc(self, ptr);
+    }
+    cy.arc.log.tracevIf(log_mem, "0 +1 alloc pool object: {*}", .{ptr});
+    if (cy.TrackGlobalRC) {
+        self.c.refCounts += 1;
+    }
+    if (cy.Trace) {
+        self.c.trace.numRetains += 1;
+        self.c.trace.numRetainAttempts += 1;
     }
+    return ptr;
 }
 
 fn freeExternalObject(vm: *cy.VM, obj: *HeapObject, len: usize, comptime cyclable: bool) void {
@@ -914,10 +1247,10 @@ fn freeExternalObject(vm: *cy.VM, obj: *HeapObject, len: usize, comptime cyclabl
             log.trace("Missing object trace {*} {}", .{obj, obj.getTypeId()});
         }
     }
+    vm.numExternalObjects -= 1;
     const ZigLenSize = if (cy.Malloc == .zig) @sizeOf(u64) else 0;
     const PayloadSize = (if (cy.hasGC and cyclable) @sizeOf(DListNode) else 0) + ZigLenSize;
-    const slice = (@as([*]align(@alignOf(HeapObject)) u8, @ptrCast(obj)) - PayloadSize)[0..len + PayloadSize];
-    vm.alloc.free(slice);
+    freeExternalBlock(vm, @as([*]align(@alignOf(HeapObject)) u8, @ptrCast(obj)) - PayloadSize, len + PayloadSize);
 }
 
 /// typeId should be cleared in trace mode since tracking may still hold a reference to the object.
@@ -931,8 +1264,15 @@ pub fn freePoolObject(vm: *cy.VM, obj: *HeapObject) void {
             log.trace("Missing object trace {*} {}", .{obj, obj.getTypeId()});
         }
     }
+    if (!cy.Trace and @as([*]HeapObject, @ptrCast(obj)) + 1 == vm.heapBumpPtr) {
+        // Most recent allocation, give it back to the bump span.
+        obj.freeSpan.typeId = NullId;
+        vm.heapBumpPtr -= 1;
+        return;
+    }
     const prev = &(@as([*]HeapObject, @ptrCast(obj)) - 1)[0];
-    if (prev.freeSpan.typeId == NullId) {
+    // The bump span has no valid span header to extend.
+    if (prev.freeSpan.typeId == NullId and !isInBumpSpan(vm, prev)) {
         // Left is a free span. Extend length.
         prev.freeSpan.start.freeSpan.len += 1;
         obj.freeSpan.start = prev.freeSpan.start;
@@ -953,6 +1293,7 @@ pub fn freePoolObject(vm: *cy.VM, obj: *HeapObject) void {
                 vm.heapFreeHead = obj;
             } else {
                 vm.heapFreeTail.?.freeSpan.next = obj;
+                vm.heapFreeTail = obj;
             }
         } else {
             // Add single slot free span.
@@ -1318,12 +1659,8 @@ pub fn allocClosure(
         }},
     };
     const dst = obj.func_union.getCapturedValuesPtr();
+    // Captured locals are either `UpValue`s or vars copied by value.
     for (captured, 0..) |local, i| {
-        if (cy.Trace) {
-            if (!fp[local.val].isUpValue()) {
-                cy.panic("Expected up value.");
-            }
-        }
         self.retain(fp[local.val]);
         dst[i] = fp[local.val];
     }
@@ -1365,56 +1702,37 @@ pub fn allocBcFuncUnion(self: *cy.VM, union_t: cy.TypeId, funcPc: usize, numPara
 }
 
 pub fn allocStringTemplate(self: *cy.VM, strs: []const cy.Inst, vals: []const Value) !Value {
-    const firstStr = Value.initRaw(self.c.consts[strs[0].val].val).asHeapObject();
-    const firstSlice = firstStr.string.getSlice();
-    try self.u8Buf.resize(self.alloc, firstSlice.len);
-    @memcpy(self.u8Buf.items(), firstSlice);
+    var sb = try cy.string.HeapStringBuilder.init(self);
+    errdefer sb.deinit();
 
-    const writer = self.u8Buf.writer(self.alloc);
-    var is_ascii = true;
+    const first = Value.initRaw(self.c.consts[strs[0].val].val).asHeapObject();
+    try sb.appendString2(first.string.getSlice(), first.string.getType().isAstring());
     for (vals, 0..) |val, i| {
         var out_ascii: bool = undefined;
         const valstr = try self.getOrBufPrintValueStr2(&cy.tempBuf, val, &out_ascii);
-        is_ascii = is_ascii and out_ascii;
-        _ = try writer.write(valstr);
+        try sb.appendString2(valstr, out_ascii);
 
         const str = Value.initRaw(self.c.consts[strs[i+1].val].val).asHeapObject();
-        is_ascii = is_ascii and str.string.getType().isAstring();
-        try self.u8Buf.appendSlice(self.alloc, str.string.getSlice());
-    }
-
-    if (is_ascii) {
-        return retainOrAllocUstring(self, self.u8Buf.items());
-    } else {
-        return retainOrAllocAstring(self, self.u8Buf.items());
+        try sb.appendString2(str.string.getSlice(), str.string.getType().isAstring());
     }
+    return sb.buildOwned();
 }
 
 pub fn allocStringTemplate2(self: *cy.VM, strs: []const Value, vals: []const Value) !Value {
-    const firstStr = strs[0].asHeapObject();
-    const firstSlice = firstStr.string.getSlice();
-    try self.u8Buf.resize(self.alloc, firstSlice.len);
-    @memcpy(self.u8Buf.items(), firstSlice);
+    var sb = try cy.string.HeapStringBuilder.init(self);
+    errdefer sb.deinit();
 
-    const writer = self.u8Buf.writer(self.alloc);
-    var is_ascii = true;
+    const first = strs[0].asHeapObject();
+    try sb.appendString2(first.string.getSlice(), first.string.getType().isAstring());
     for (vals, 0..) |val, i| {
         var out_ascii: bool = undefined;
         const valstr = try self.getOrBufPrintValueStr2(&cy.tempBuf, val, &out_ascii);
-        is_ascii = is_ascii and out_ascii;
-        _ = try writer.write(valstr);
+        try sb.appendString2(valstr, out_ascii);
 
         const str = strs[i+1].asHeapObject();
-        is_ascii = is_ascii and str.string.getType().isAstring();
-
-        try self.u8Buf.appendSlice(self.alloc, str.string.getSlice());
-    }
-
-    if (is_ascii) {
-        return retainOrAllocUstring(self, self.u8Buf.items());
-    } else {
-        return retainOrAllocAstring(self, self.u8Buf.items());
+        try sb.appendString2(str.string.getSlice(), str.string.getType().isAstring());
     }
+    return sb.buildOwned();
 }
 
 pub fn getOrAllocOwnedAstring(self: *cy.VM, obj: *HeapObject) !Value {
@@ -1467,121 +1785,143 @@ fn allocAstringConcatObject(self: *cy.VM, str1: []const u8, str2: []const u8) !*
 }
 
 pub fn getOrAllocAstringConcat(self: *cy.VM, str: []const u8, str2: []const u8) !Value {
-    if (str.len + str2.len <= DefaultStringInternMaxByteLen) {
-        const concat = self.tempBuf[0..str.len+str2.len];
-        @memcpy(concat[0..str.len], str);
-        @memcpy(concat[str.len..], str2);
-
-        const res = try self.strInterns.getOrPut(self.alloc, concat);
-        if (res.found_existing) {
-            cy.arc.retainObject(self, res.value_ptr.*);
-            return Value.initNoCycPtr(res.value_ptr.*);
-        } else {
-            const obj = try allocAstringObject(self, concat);
-            res.key_ptr.* = obj.astring.getSlice();
-            res.value_ptr.* = obj;
-            return Value.initNoCycPtr(obj);
-        }
-    } else {
-        const obj = try allocAstringConcatObject(self, str, str2);
-        return Value.initNoCycPtr(obj);
-    }
+    const obj = try allocAstringConcatObject(self, str, str2);
+    return Value.initNoCycPtr(obj);
 }
 
 pub fn getOrAllocAstringConcat3(self: *cy.VM, str1: []const u8, str2: []const u8, str3: []const u8) !Value {
-    if (str1.len + str2.len + str3.len <= DefaultStringInternMaxByteLen) {
-        const concat = self.tempBuf[0..str1.len+str2.len+str3.len];
-        @memcpy(concat[0..str1.len], str1);
-        @memcpy(concat[str1.len..str1.len+str2.len], str2);
-        @memcpy(concat[str1.len+str2.len..], str3);
-
-        const res = try self.strInterns.getOrPut(self.alloc, concat);
-        if (res.found_existing) {
-            cy.arc.retainObject(self, res.value_ptr.*);
-            return Value.initNoCycPtr(res.value_ptr.*);
-        } else {
-            const obj = try allocAstringObject(self, concat);
-            res.key_ptr.* = obj.astring.getSlice();
-            res.value_ptr.* = obj;
-            return Value.initNoCycPtr(obj);
-        }
-    } else {
-        const obj = try allocAstringConcat3Object(self, str1, str2, str3);
-        return Value.initNoCycPtr(obj);
-    }
+    const obj = try allocAstringConcat3Object(self, str1, str2, str3);
+    return Value.initNoCycPtr(obj);
 }
 
 pub fn getOrAllocUstringConcat3(self: *cy.VM, str1: []const u8, str2: []const u8, str3: []const u8) !Value {
-    if (str1.len + str2.len + str3.len <= DefaultStringInternMaxByteLen) {
-        const concat = self.tempBuf[0..str1.len+str2.len+str3.len];
-        @memcpy(concat[0..str1.len], str1);
-        @memcpy(concat[str1.len..str1.len+str2.len], str2);
-        @memcpy(concat[str1.len+str2.len..], str3);
+    const obj = try allocUstringConcat3Object(self, str1, str2, str3);
+    return Value.initNoCycPtr(obj);
+}
 
-        const res = try self.strInterns.getOrPut(self.alloc, concat);
-        if (res.found_existing) {
-            cy.arc.retainObject(self, res.value_ptr.*);
-            return Value.initNoCycPtr(res.value_ptr.*);
-        } else {
-            const obj = try allocUstringObject(self, concat);
-            res.key_ptr.* = obj.ustring.getSlice();
-            res.value_ptr.* = obj;
-            return Value.initNoCycPtr(obj);
-        }
+pub fn getOrAllocUstringConcat(self: *cy.VM, str: []const u8, str2: []const u8) !Value {
+    const obj = try allocUstringConcatObject(self, str, str2);
+    return Value.initNoCycPtr(obj);
+}
+
+const DefaultStringInternMaxByteLen = 64;
+
+/// Turns a string buffer with `len` bytes written into a string and takes over the buffer's reference.
+/// The buffer is reused when it is a pool object or when its capacity matches a growable string,
+/// otherwise the bytes are copied into a new string.
+pub fn ownStringBuffer(self: *cy.VM, buf_obj: *HeapObject, len: usize, is_ascii: bool) !Value {
+    const cap = buf_obj.string.len();
+    const stype: StringType = if (is_ascii) .astring else .ustring;
+    const max_pool_len = if (is_ascii) MaxPoolObjectAstringByteLen else MaxPoolObjectUstringByteLen;
+    if (cap <= MaxPoolObjectAstringByteLen and len <= max_pool_len) {
+        buf_obj.string.headerAndLen = (@as(u32, @intFromEnum(stype)) << 30) | @as(u32, @intCast(len));
+        return Value.initNoCycPtr(buf_obj);
+    }
+    if (len > DefaultStringInternMaxByteLen and cap == growableStringCap(len)) {
+        buf_obj.string.headerAndLen = (@as(u32, @intFromEnum(stype)) << 30) | StringFlagBit | @as(u32, @intCast(len));
+        return Value.initNoCycPtr(buf_obj);
+    }
+
+    defer cy.arc.releaseObject(self, buf_obj);
+    const str = buf_obj.astring.getSlice()[0..len];
+    if (is_ascii) {
+        return retainOrAllocAstring(self, str);
     } else {
-        const obj = try allocUstringConcat3Object(self, str1, str2, str3);
-        return Value.initNoCycPtr(obj);
+        return retainOrAllocUstring(self, str);
     }
 }
 
-pub fn getOrAllocUstringConcat(self: *cy.VM, str: []const u8, str2: []const u8) !Value {
-    if (str.len + str2.len <= DefaultStringInternMaxByteLen) {
-        const concat = self.tempBuf[0..str.len+str2.len];
-        @memcpy(concat[0..str.len], str);
-        @memcpy(concat[str.len..], str2);
-
-        const res = try self.strInterns.getOrPut(self.alloc, concat);
-        if (res.found_existing) {
-            cy.arc.retainObject(self, res.value_ptr.*);
-            return Value.initNoCycPtr(res.value_ptr.*);
+/// Appends `str` to `obj` for an assignment that replaces `obj` with the result.
+/// A growable string that is only referenced by the destination is appended to in place
+/// and returned with a new reference. Otherwise, a new growable string is returned.
+/// Short results are copied like a regular concat.
+pub fn appendStringInPlace(self: *cy.VM, obj: *String, str: []const u8, str_ascii: bool) !Value {
+    const len = obj.len();
+    const new_len = len + str.len;
+    if (new_len > MaxStringByteLen) {
+        return error.StringTooLong;
+    }
+    const stype: StringType = if (obj.getType().isAstring() and str_ascii) .astring else .ustring;
+    if (new_len <= DefaultStringInternMaxByteLen) {
+        if (stype == .astring) {
+            return getOrAllocAstringConcat(self, obj.getSlice(), str);
         } else {
-            const obj = try allocUstringObject(self, concat);
-            res.key_ptr.* = obj.ustring.getSlice();
-            res.value_ptr.* = obj;
-            return Value.initNoCycPtr(obj);
+            return getOrAllocUstringConcat(self, obj.getSlice(), str);
         }
-    } else {
-        const obj = try allocUstringConcatObject(self, str, str2);
+    }
+    if (obj.rc == 1 and obj.isGrowable() and new_len <= growableStringCap(len)) {
+        if (!obj.getType().isAstring()) {
+            invalidateRuneSeek(self, @ptrCast(obj));
+        }
+        const buf: [*]u8 = @ptrCast(&@as(*Astring, @ptrCast(obj)).bufStart);
+        @memcpy(buf[len..new_len], str);
+        obj.headerAndLen = (@as(u32, @intFromEnum(stype)) << 30) | StringFlagBit | @as(u32, @intCast(new_len));
+        cy.arc.retainObject(self, @ptrCast(obj));
         return Value.initNoCycPtr(obj);
     }
-}
 
-const DefaultStringInternMaxByteLen = 64;
+    const new_obj = try allocExternalObject(self, Astring.BufOffset + growableStringCap(new_len), false);
+    new_obj.astring = .{
+        .typeId = bt.String,
+        .rc = 1,
+        .headerAndLen = (@as(u32, @intFromEnum(stype)) << 30) | StringFlagBit | @as(u32, @intCast(new_len)),
+        .bufStart = undefined,
+    };
+    const dst = new_obj.astring.getMutSlice();
+    @memcpy(dst[0..len], obj.getSlice());
+    @memcpy(dst[len..], str);
+    return Value.initNoCycPtr(new_obj);
+}
 
-// If no such string intern exists, `obj` is added as a string intern.
-// Otherwise, `obj` is released and the existing string intern is retained and returned.
+/// Runtime strings are not interned on creation so `obj` is returned as is.
 pub fn getOrAllocOwnedString(self: *cy.VM, obj: *HeapObject, str: []const u8) !Value {
-    if (str.len <= DefaultStringInternMaxByteLen) {
-        const res = try self.strInterns.getOrPut(self.alloc, str);
-        if (res.found_existing) {
-            cy.arc.releaseObject(self, obj);
-            cy.arc.retainObject(self, res.value_ptr.*);
-            return Value.initNoCycPtr(res.value_ptr.*);
-        } else {
-            res.key_ptr.* = str;
-            res.value_ptr.* = obj;
-            return Value.initNoCycPtr(obj);
-        }
+    _ = self;
+    _ = str;
+    return Value.initNoCycPtr(obj);
+}
+
+/// Returns the interned string equal to `str` with a retained reference.
+/// If no such intern exists, `str` becomes the intern.
+/// Slices and strings longer than `DefaultStringInternMaxByteLen` are returned retained as is.
+pub fn retainOrInternString(self: *cy.VM, str: *String) !Value {
+    cy.arc.retainObject(self, @ptrCast(str));
+    if (str.isInterned() or str.isSlice() or str.len() > DefaultStringInternMaxByteLen) {
+        return Value.initNoCycPtr(str);
+    }
+    const slice = str.getSlice();
+    const res = try self.strInterns.getOrPut(self.alloc, slice);
+    if (res.found_existing) {
+        cy.arc.releaseObject(self, @ptrCast(str));
+        cy.arc.retainObject(self, res.value_ptr.*);
+        return Value.initNoCycPtr(res.value_ptr.*);
     } else {
-        return Value.initNoCycPtr(obj);
+        str.headerAndLen |= StringFlagBit;
+        res.key_ptr.* = slice;
+        res.value_ptr.* = @ptrCast(str);
+        return Value.initNoCycPtr(str);
     }
 }
 
+/// Like `retainOrAllocAstring` and `retainOrAllocUstring` except the result is interned.
+/// Meant for strings that are likely to be repeated such as map keys.
+pub fn retainOrAllocInternedString(self: *cy.VM, str: []const u8) !Value {
+    var allocated: bool = undefined;
+    const res = if (cy.string.isAstring(str))
+        try getOrAllocAstring(self, str, &allocated)
+    else
+        try getOrAllocUstring(self, str, &allocated);
+    if (!allocated) {
+        cy.arc.retain(self, res);
+    }
+    return res;
+}
+
 const Root = @This();
 pub const VmExt = struct {
     pub const allocString = Root.allocString;
     pub const retainOrAllocAstring = Root.retainOrAllocAstring;
     pub const retainOrAllocUstring = Root.retainOrAllocUstring;
+    pub const allocInternedString = Root.retainOrAllocInternedString;
     pub const allocAstringConcat = Root.getOrAllocAstringConcat;
     pub const allocUstringConcat = Root.getOrAllocUstringConcat;
     pub const allocAstringConcat3 = Root.getOrAllocAstringConcat3;
@@ -1618,6 +1958,7 @@ pub const VmExt = struct {
     pub const allocTrait = Root.allocTrait;
     pub const allocFuture = Root.allocFuture;
     pub const allocFutureResolver = Root.allocFutureResolver;
+    pub const allocListValue = Root.allocListValue;
 
     pub fn mapSet(vm: *cy.VM, map: *Map, key: Value, val: Value) !void {
         try map.map().put(vm.alloc, key, val);
@@ -1640,6 +1981,9 @@ pub fn allocAstring(self: *cy.VM, str: []const u8) !Value {
 }
 
 pub fn allocUnsetAstringObject(self: *cy.VM, len: usize) !*HeapObject {
+    if (len > MaxStringByteLen) {
+        return error.StringTooLong;
+    }
     var obj: *HeapObject = undefined;
     if (len <= MaxPoolObjectAstringByteLen) {
         obj = try allocPoolObject(self);
@@ -1655,15 +1999,13 @@ pub fn allocUnsetAstringObject(self: *cy.VM, len: usize) !*HeapObject {
     return obj;
 }
 
+/// Runtime strings are not interned to avoid hashing every allocation and free.
 pub fn retainOrAllocUstring(self: *cy.VM, str: []const u8) !Value {
-    var allocated: bool = undefined;
-    const res = try getOrAllocUstring(self, str, &allocated);
-    if (!allocated) {
-        cy.arc.retain(self, res);
-    }
-    return res;
+    const obj = try allocUstringObject(self, str);
+    return Value.initNoCycPtr(obj);
 }
 
+/// Returns an interned string. Used for compile-time constants.
 pub fn getOrAllocUstring(self: *cy.VM, str: []const u8, outAllocated: *bool) !Value {
     if (str.len <= DefaultStringInternMaxByteLen) {
         const res = try self.strInterns.getOrPut(self.alloc, str);
@@ -1673,6 +2015,7 @@ pub fn getOrAllocUstring(self: *cy.VM, str: []const u8, outAllocated: *bool) !Va
         } else {
             outAllocated.* = true;
             const obj = try allocUstringObject(self, str);
+            obj.string.headerAndLen |= StringFlagBit;
             res.key_ptr.* = obj.ustring.getSlice();
             res.value_ptr.* = obj;
             return Value.initNoCycPtr(obj);
@@ -1684,15 +2027,13 @@ pub fn getOrAllocUstring(self: *cy.VM, str: []const u8, outAllocated: *bool) !Va
     }
 }
 
+/// Runtime strings are not interned to avoid hashing every allocation and free.
 pub fn retainOrAllocAstring(self: *cy.VM, str: []const u8) !Value {
-    var allocated: bool = undefined;
-    const res = try getOrAllocAstring(self, str, &allocated);
-    if (!allocated) {
-        cy.arc.retain(self, res);
-    }
-    return res;
+    const obj = try allocAstringObject(self, str);
+    return Value.initNoCycPtr(obj);
 }
 
+/// Returns an interned string. Used for compile-time constants.
 pub fn getOrAllocAstring(self: *cy.VM, str: []const u8, outAllocated: *bool) !Value {
     if (str.len <= DefaultStringInternMaxByteLen) {
         const res = try self.strInterns.getOrPut(self.alloc, str);
@@ -1702,6 +2043,7 @@ pub fn getOrAllocAstring(self: *cy.VM, str: []const u8, outAllocated: *bool) !Va
         } else {
             outAllocated.* = true;
             const obj = try allocAstringObject(self, str);
+            obj.string.headerAndLen |= StringFlagBit;
             res.key_ptr.* = obj.astring.getSlice();
             res.value_ptr.* = obj;
             return Value.initNoCycPtr(obj);
@@ -1726,6 +2068,9 @@ pub fn allocUstringObject(self: *cy.VM, str: []const u8) !*HeapObject {
 }
 
 pub fn allocUnsetUstringObject(self: *cy.VM, len: usize) !*HeapObject {
+    if (len > MaxStringByteLen) {
+        return error.StringTooLong;
+    }
     var obj: *HeapObject = undefined;
     if (len <= MaxPoolObjectUstringByteLen) {
         obj = try allocPoolObject(self);
@@ -1741,7 +2086,23 @@ pub fn allocUnsetUstringObject(self: *cy.VM, len: usize) !*HeapObject {
     return obj;
 }
 
+/// Drops cached rune seek state for a ustring that is about to be freed.
+fn invalidateRuneSeek(vm: *cy.VM, obj: *HeapObject) void {
+    if (vm.ustrRuneCursor.obj == @as(*anyopaque, @ptrCast(obj))) {
+        vm.ustrRuneCursor.obj = null;
+    }
+    if (obj.string.len() >= cy.string.RuneIndexMinByteLen and vm.ustrRuneIndexes.size > 0) {
+        if (vm.ustrRuneIndexes.fetchRemove(obj)) |entry| {
+            var index = entry.value;
+            index.deinit(vm.alloc);
+        }
+    }
+}
+
 pub fn allocUstringSlice(self: *cy.VM, slice: []const u8, parent: ?*HeapObject) !Value {
+    if (slice.len > MaxStringByteLen) {
+        return error.StringTooLong;
+    }
     const obj = try allocPoolObject(self);
     obj.uslice = .{
         .typeId = bt.String,
@@ -1754,6 +2115,9 @@ pub fn allocUstringSlice(self: *cy.VM, slice: []const u8, parent: ?*HeapObject)
 }
 
 pub fn allocAstringSlice(self: *cy.VM, slice: []const u8, parent: *HeapObject) !Value {
+    if (slice.len > MaxStringByteLen) {
+        return error.StringTooLong;
+    }
     const obj = try allocPoolObject(self);
     obj.aslice = .{
         .typeId = bt.String,
@@ -1836,19 +2200,16 @@ pub fn allocHostFuncUnion(self: *cy.VM, union_t: cy.TypeId, func: cy.ZHostFuncFn
     return Value.initNoCycPtr(obj);
 }
 
-pub fn allocTccState(self: *cy.VM, state: *tcc.TCCState, optLib: ?*std.DynLib) !Value {
+pub fn allocTccState(self: *cy.VM, state: ?*tcc.TCCState, lib: ?*std.DynLib) !Value {
     const obj = try allocPoolObject(self);
     obj.tccState = .{
         .typeId = bt.TccState,
         .rc = 1,
         .state = state,
-        .lib = undefined,
-        .hasDynLib = false,
+        .lib = lib,
+        .shim = null,
+        .trampolines = null,
     };
-    if (optLib) |lib| {
-        obj.tccState.lib = lib;
-        obj.tccState.hasDynLib = true;
-    }
     return Value.initNoCycPtr(obj);
 }
 
@@ -2117,40 +2478,30 @@ pub fn freeObject(vm: *cy.VM, obj: *HeapObject, comptime skip_cyc_children: bool
             freePoolObject(vm, obj);
         },
         bt.String => {
+            if (!obj.string.getType().isAstring()) {
+                invalidateRuneSeek(vm, obj);
+            }
             switch (obj.string.getType()) {
                 .astring => {
                     const len = obj.string.len();
-                    if (len <= DefaultStringInternMaxByteLen) {
-
-                        // Check both the key and value to make sure this object is the intern entry.
-                        // TODO: Use a flag bit instead of a map query.
-                        const key = obj.astring.getSlice();
-                        if (vm.strInterns.get(key)) |val| {
-                            if (val == obj) {
-                                _ = vm.strInterns.remove(key);
-                            }
-                        }
+                    if (obj.string.isInterned()) {
+                        _ = vm.strInterns.remove(obj.astring.getSlice());
                     }
                     if (len <= MaxPoolObjectAstringByteLen) {
                         freePoolObject(vm, obj);
                     } else {
-                        freeExternalObject(vm, obj, Astring.BufOffset + len, false);
+                        freeExternalObject(vm, obj, Astring.BufOffset + obj.string.bufCap(), false);
                     }
                 },
                 .ustring => {
                     const len = obj.string.len();
-                    if (len <= DefaultStringInternMaxByteLen) {
-                        const key = obj.ustring.getSlice();
-                        if (vm.strInterns.get(key)) |val| {
-                            if (val == obj) {
-                                _ = vm.strInterns.remove(key);
-                            }
-                        }
+                    if (obj.string.isInterned()) {
+                        _ = vm.strInterns.remove(obj.ustring.getSlice());
                     }
                     if (len <= MaxPoolObjectUstringByteLen) {
                         freePoolObject(vm, obj);
                     } else {
-                        freeExternalObject(vm, obj, Ustring.BufOffset + len, false);
+                        freeExternalObject(vm, obj, Ustring.BufOffset + obj.string.bufCap(), false);
                     }
                 },
                 .aslice => {
@@ -2189,10 +2540,20 @@ pub fn freeObject(vm: *cy.VM, obj: *HeapObject, comptime skip_cyc_children: bool
         }, 
         bt.TccState => {
             if (cy.hasFFI) {
-                tcc.tcc_delete(obj.tccState.state);
-                if (obj.tccState.hasDynLib) {
-                    obj.tccState.lib.close();
-                    vm.alloc.destroy(obj.tccState.lib);
+                if (obj.tccState.state) |state| {
+                    tcc.tcc_delete(state);
+                }
+                if (obj.tccState.shim) |shim| {
+                    shim.close();
+                    vm.alloc.destroy(shim);
+                }
+                if (obj.tccState.trampolines) |trampolines| {
+                    trampolines.deinit();
+                    vm.alloc.destroy(trampolines);
+                }
+                if (obj.tccState.lib) |lib| {
+                    lib.close();
+                    vm.alloc.destroy(lib);
                 }
                 freePoolObject(vm, obj);
             } else {
@@ -2430,6 +2791,200 @@ test "Free object invalidation." {
     }
 }
 
+test "External object size classes." {
+    var vm: cy.VM = undefined;
+    try vm.init(t.alloc);
+    defer vm.deinit(false);
+
+    if (UseExternalFreeLists) {
+        try t.eq(externalSizeClass(1), 0);
+        try t.eq(externalSizeClass(64), 0);
+        try t.eq(externalSizeClass(65), 1);
+        try t.eq(externalSizeClass(256), ExternalSizeClasses.len-1);
+        try t.eq(externalSizeClass(257), null);
+
+        // Freed blocks are reused by any size in the same class.
+        const obj = try allocExternalObject(&vm, 100, false);
+        freeExternalObject(&vm, obj, 100, false);
+        const class = externalSizeClass(100 + (if (cy.Malloc == .zig) 8 else 0)).?;
+        try t.eq(vm.externalFreeLists[class].len, 1);
+        const obj2 = try allocExternalObject(&vm, 90, false);
+        try t.eq(obj2, obj);
+        try t.eq(vm.externalFreeLists[class].len, 0);
+        freeExternalObject(&vm, obj2, 90, false);
+
+        // Large objects bypass the free lists.
+        const big = try allocExternalObject(&vm, 1000, false);
+        freeExternalObject(&vm, big, 1000, false);
+        try t.eq(vm.externalFreeLists[class].len, 1);
+    }
+}
+
+test "Release free heap pages." {
+    var vm: cy.VM = undefined;
+    try vm.init(t.alloc);
+    defer vm.deinit(false);
+
+    if (!cy.Trace) {
+        const start = getHeapStats(&vm);
+
+        var objs: std.ArrayListUnmanaged(*HeapObject) = .{};
+        defer objs.deinit(t.alloc);
+        for (0..2000) |_| {
+            const obj = try allocPoolObject(&vm);
+            obj.head.typeId = 100;
+            try objs.append(t.alloc, obj);
+        }
+        try t.eq(getHeapStats(&vm).live_objects, start.live_objects + 2000);
+        const peak_pages = vm.heapPages.len;
+
+        for (objs.items) |obj| {
+            freePoolObject(&vm, obj);
+        }
+        flushBumpSpan(&vm);
+        rebuildFreeSpans(&vm);
+
+        const stats = getHeapStats(&vm);
+        try t.eq(stats.live_objects, start.live_objects);
+        try t.eq(stats.pages < peak_pages, true);
+        try t.eq(stats.pages >= DefaultMinHeapPages, true);
+
+        // Free slots are coalesced into at most one span between live objects.
+        try t.eq(stats.free_spans <= stats.live_objects + stats.pages, true);
+    }
+}
+
+/// Stops at an `end` inst so that gc doesn't walk the stack of a VM that isn't running.
+var GcTestEndInst = [_]cy.Inst{ cy.Inst.initOpCode(.end) };
+
+fn isInHeapPage(vm: *cy.VM, obj: *HeapObject) bool {
+    for (vm.heapPages.items()) |page| {
+        const start = @intFromPtr(&page.objects);
+        if (@intFromPtr(obj) >= start and @intFromPtr(obj) < start + @sizeOf(@TypeOf(page.objects))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+test "GC of a cycle below the bump pointer." {
+    var vm: cy.VM = undefined;
+    try vm.init(t.alloc);
+    defer vm.deinit(false);
+
+    if (cy.hasGC and !cy.Trace) {
+        vm.c.pc = &GcTestEndInst;
+
+        // The cycle is the last pool allocation, so sweeping it frees the slots right below `heapBumpPtr`.
+        const a = try allocEmptyListDyn(&vm);
+        const b = try allocEmptyListDyn(&vm);
+        try a.asHeapObject().list.append(vm.alloc, b);
+        try b.asHeapObject().list.append(vm.alloc, a);
+        const res = try cy.arc.performGC(&vm);
+        try t.eq(res.numCycFreed, 2);
+
+        // Each slot is handed out once.
+        var objs: [8]*HeapObject = undefined;
+        for (&objs) |*obj| {
+            obj.* = try allocPoolObject(&vm);
+            obj.*.head.typeId = 100;
+        }
+        for (objs, 0..) |obj, i| {
+            for (objs[i+1..]) |other| {
+                try t.expect(obj != other);
+            }
+        }
+        for (objs) |obj| {
+            freePoolObject(&vm, obj);
+        }
+    }
+}
+
+test "Allocate after GC releases heap pages." {
+    var vm: cy.VM = undefined;
+    try vm.init(t.alloc);
+    defer vm.deinit(false);
+
+    if (cy.hasGC and !cy.Trace) {
+        vm.c.pc = &GcTestEndInst;
+
+        // Fill whole pages and free them in allocation order so the last frees rewind the bump span.
+        var objs: std.ArrayListUnmanaged(*HeapObject) = .{};
+        defer objs.deinit(t.alloc);
+        for (0..2000) |_| {
+            const obj = try allocPoolObject(&vm);
+            obj.head.typeId = 100;
+            try objs.append(t.alloc, obj);
+        }
+        const peak_pages = vm.heapPages.len;
+        for (objs.items) |obj| {
+            freePoolObject(&vm, obj);
+        }
+        _ = try cy.arc.performGC(&vm);
+        try t.expect(vm.heapPages.len < peak_pages);
+
+        // New objects come from pages that are still owned by the heap.
+        objs.clearRetainingCapacity();
+        for (0..2000) |_| {
+            const obj = try allocPoolObject(&vm);
+            try t.expect(isInHeapPage(&vm, obj));
+            obj.head.typeId = 100;
+            try objs.append(t.alloc, obj);
+        }
+        for (objs.items) |obj| {
+            freePoolObject(&vm, obj);
+        }
+    }
+}
+
+test "String interning." {
+    var vm: cy.VM = undefined;
+    try vm.init(t.alloc);
+    defer vm.deinit(false);
+
+    // Runtime strings are not interned.
+    const num_interns = vm.strInterns.count();
+    const a = try retainOrAllocAstring(&vm, "abc");
+    const b = try retainOrAllocAstring(&vm, "abc");
+    try t.expect(a.asHeapObject() != b.asHeapObject());
+    try t.eq(a.asHeapObject().string.isInterned(), false);
+    try t.eq(vm.strInterns.count(), num_interns);
+
+    // Interned on demand.
+    const ia = try retainOrInternString(&vm, &a.asHeapObject().string);
+    try t.eq(ia.asHeapObject(), a.asHeapObject());
+    try t.eq(a.asHeapObject().string.isInterned(), true);
+    try t.eq(a.asHeapObject().string.len(), 3);
+    const ib = try retainOrInternString(&vm, &b.asHeapObject().string);
+    try t.eq(ib.asHeapObject(), a.asHeapObject());
+    try t.eq(vm.strInterns.count(), num_interns + 1);
+
+    vm.release(ib);
+    vm.release(b);
+    vm.release(ia);
+    vm.release(a);
+    try t.eq(vm.strInterns.count(), num_interns);
+}
+
+test "String length limit." {
+    var vm: cy.VM = undefined;
+    try vm.init(t.alloc);
+    defer vm.deinit(false);
+
+    // Checked before allocating.
+    try t.expectError(allocUnsetAstringObject(&vm, MaxStringByteLen + 1), error.StringTooLong);
+    try t.expectError(allocUnsetUstringObject(&vm, MaxStringByteLen + 1), error.StringTooLong);
+
+    // Appending past the limit. The length is faked since the check happens before copying.
+    const str = try retainOrAllocAstring(&vm, "abc");
+    const obj = &str.asHeapObject().string;
+    const header = obj.headerAndLen;
+    obj.headerAndLen = (@as(u32, @intFromEnum(StringType.astring)) << 30) | MaxStringByteLen;
+    try t.expectError(appendStringInPlace(&vm, obj, "x", true), error.StringTooLong);
+    obj.headerAndLen = header;
+    vm.release(str);
+}
+
 test "heap internals." {
     try t.eq(@sizeOf(AsyncTask), 16);
     if (cy.is32Bit) {
@@ -2470,7 +3025,7 @@ test "heap internals." {
         try t.eq(@sizeOf(Object), 16);
         try t.eq(@sizeOf(UpValue), 16);
         if (cy.hasFFI) {
-            try t.eq(@sizeOf(TccState), 32);
+            try t.eq(@sizeOf(TccState), 40);
         }
     }
 
@@ -481,6 +481,17 @@ bool clExpandTemplateType(CLVM* vm, CLSym type_t, const CLValue* args, size_t na
 // Returns `CL_TYPE_NULL` if the symbol could not be found or the symbol is not a type.
 CLType clFindType(CLVM* vm, CLStr path);
 
+// Find a function from an absolute path and write a callable handle to `out`.
+// The handle skips the symbol lookup on every call and can be reused with `clCall`
+// until the VM is reset. Release it with `clRelease`.
+// Returns false if the symbol could not be found, is not a function, or is overloaded.
+bool clFindFunc(CLVM* vm, CLStr path, CLValue* out);
+
+// Calls a function value with `nargs` arguments. The arguments are borrowed.
+// On success, the owned return value is written to `out`.
+// Returns `CL_ERROR_UNKNOWN` if `nargs` is greater than 255.
+CLResultCode clCall(CLVM* vm, CLValue func, const CLValue* args, size_t nargs, CLValue* out);
+
 // -----------------------------------
 // [ Memory ]
 // -----------------------------------
@@ -509,6 +520,34 @@ size_t clGetGlobalRC(CLVM* vm);
 // This can be used to check if all objects were cleaned up after `clDeinit`.
 size_t clCountObjects(CLVM* vm);
 
+typedef struct CLHeapStats {
+    // Number of object pool pages and their total size in bytes.
+    size_t pages;
+    size_t pageBytes;
+
+    // Live objects in pool pages.
+    size_t liveObjects;
+
+    // Free pool slots, the number of free spans they are split into and the largest span.
+    // `largestFreeSpan / freeSlots` approaches 1 as the pool is less fragmented.
+    size_t freeSlots;
+    size_t freeSpans;
+    size_t largestFreeSpan;
+
+    // Live objects allocated outside of pool pages.
+    size_t externalObjects;
+
+    // Bytes held by freed external object blocks that are kept for reuse.
+    size_t externalCachedBytes;
+} CLHeapStats;
+
+// Returns a snapshot of the object heap. Walks every pool page.
+CLHeapStats clGetHeapStats(CLVM* vm);
+
+// After a GC run, pool pages that are fully free are released to the allocator
+// as long as at least `pages` pages remain. Defaults to 4.
+void clSetHeapMinPages(CLVM* vm, size_t pages);
+
 // TRACE mode: Dump live objects recorded in global object map.
 void clTraceDumpLiveObjects(CLVM* vm);
 
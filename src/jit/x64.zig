@@ -109,6 +109,25 @@ pub const Encoder = struct {
         self.buf.items.len += len;
     }
 
+    pub fn popReg(self: Encoder, r: Register) !void {
+        const enc = Encoding.init(.o, 0, .none, .none);
+        const out = try self.prepInstBuf();
+        const len = self.encodeHeader(out, enc, &.{ 0x58 }, &.{ Op.reg(r) });
+        self.buf.items.len += len;
+    }
+
+    /// Sign extends the low 32 bits of `src`.
+    pub fn movsxd(self: Encoder, dst: Register, src: Register) !void {
+        const enc = Encoding.init(.rm, 0, .long, .none);
+        try self.encode(enc, &.{ 0x63 }, &.{ Op.reg(dst), Op.reg(src) });
+    }
+
+    /// Copies the low 32 bits of `src` and zero extends.
+    pub fn movReg32(self: Encoder, dst: Register, src: Register) !void {
+        const enc = Encoding.init(.rm, 0, .none, .none);
+        try self.encode(enc, &.{ 0x8b }, &.{ Op.reg(dst), Op.reg(src) });
+    }
+
     pub fn movImm(self: Encoder, dst: Register, imm: u64) !void {
         const enc = Encoding.init(.oi, 0, .long, .none);
         const out = try self.prepInstBuf();
@@ -654,10 +673,22 @@ test "x64 encoding" {
     try encoder.pushReg(.rbp);
     try t.eqSlice(u8, buf.items, &.{ 0x55 });
 
+    buf.clearRetainingCapacity();
+    try encoder.popReg(.rbp);
+    try t.eqSlice(u8, buf.items, &.{ 0x5d });
+
     buf.clearRetainingCapacity();
     try encoder.movReg(.rbp, .rsp);
     try t.eqSlice(u8, buf.items, &.{ 0x48, 0x8b, 0xec });
 
+    buf.clearRetainingCapacity();
+    try encoder.movsxd(.rax, .rax);
+    try t.eqSlice(u8, buf.items, &.{ 0x48, 0x63, 0xc0 });
+
+    buf.clearRetainingCapacity();
+    try encoder.movReg32(.rax, .rax);
+    try t.eqSlice(u8, buf.items, &.{ 0x8b, 0xc0 });
+
     buf.clearRetainingCapacity();
     try encoder.cmp(.rdx, .rcx);
     try t.eqSlice(u8, buf.items, &.{ 0x48, 0x3b, 0xd1 });
@@ -49,6 +49,24 @@ export fn clCountObjects(vm: *cy.VM) usize {
     return cy.arc.countObjects(vm);
 }
 
+export fn clGetHeapStats(vm: *cy.VM) c.HeapStats {
+    const stats = cy.heap.getHeapStats(vm);
+    return .{
+        .pages = stats.pages,
+        .pageBytes = stats.pages * @sizeOf(cy.heap.HeapPage),
+        .liveObjects = stats.live_objects,
+        .freeSlots = stats.free_slots,
+        .freeSpans = stats.free_spans,
+        .largestFreeSpan = stats.largest_free_span,
+        .externalObjects = stats.external_objects,
+        .externalCachedBytes = stats.external_cached_bytes,
+    };
+}
+
+export fn clSetHeapMinPages(vm: *cy.VM, pages: usize) void {
+    vm.heapMinPages = pages;
+}
+
 export fn clTraceDumpLiveObjects(vm: *cy.VM) void {
     if (cy.Trace) {
         var iter = vm.objectTraceMap.iterator();
@@ -504,6 +522,96 @@ test "clFindType()" {
     try t.expect(vm.findType("Foo") != c.TypeNull);
 }
 
+export fn clFindFunc(vm: *cy.VM, c_path: c.Str, out: *cy.Value) bool {
+    const func = findFunc(vm, c.fromStr(c_path)) orelse {
+        return false;
+    };
+    // Only functions that were generated for the last compile have a runtime id.
+    const entry = vm.compiler.genSymMap.get(func) orelse {
+        return false;
+    };
+    const rt_func = vm.funcSyms.buf[entry.func.id];
+    out.* = cy.heap.allocFunc(vm, rt_func) catch fatal();
+    return true;
+}
+
+fn findFunc(vm: *cy.VM, path: []const u8) ?*cy.Func {
+    if (vm.compiler.chunks.items.len == 0) {
+        return null;
+    }
+
+    // Look in main first.
+    const main_mod = vm.compiler.main_chunk.sym.getMod();
+    const sym = main_mod.getSym(path) orelse b: {
+        // Look in builtins.
+        const b_mod = vm.compiler.chunks.items[0].sym.getMod();
+        break :b b_mod.getSym(path) orelse return null;
+    };
+    if (sym.type != .func) {
+        return null;
+    }
+    // Overloaded functions are ambiguous without a signature.
+    const func_sym = sym.cast(.func);
+    if (func_sym.numFuncs != 1) {
+        return null;
+    }
+    return func_sym.first;
+}
+
+export fn clCall(vm: *cy.VM, func: cy.Value, args: [*]const cy.Value, nargs: usize, out: *cy.Value) c.ResultCode {
+    if (nargs > std.math.maxInt(u8)) {
+        // Call frames only encode a u8 arg count.
+        vm.last_res = c.ErrorUnknown;
+        return c.ErrorUnknown;
+    }
+    var res = c.Success;
+    out.* = vm.callFunc(func, args[0..nargs], .{}) catch |err| b: {
+        switch (err) {
+            error.Panic => {
+                res = c.ErrorPanic;
+            },
+            else => {
+                log.tracev("{}", .{err});
+                res = c.ErrorUnknown;
+            },
+        }
+        break :b undefined;
+    };
+    vm.last_res = res;
+    return res;
+}
+
+test "clFindFunc() clCall()" {
+    const vm = c.create();
+    defer vm.destroy();
+
+    var res: c.Value = undefined;
+    vm.evalMust(
+        \\func add(a int, b int) int:
+        \\    return a + b
+        \\var .Foo = 123
+    , &res);
+    vm.release(res);
+
+    var func: c.Value = undefined;
+    try t.eq(vm.findFunc("missing", &func), false);
+    try t.eq(vm.findFunc("Foo", &func), false);
+    try t.eq(vm.findFunc("add", &func), true);
+    defer vm.release(func);
+
+    // Reuse the handle across calls.
+    for (0..3) |i| {
+        const args = [_]c.Value{ vm.newInt(@intCast(i)), vm.newInt(10) };
+        try t.eq(vm.call(func, &args, &res), c.Success);
+        try t.eq(c.asBoxInt(res), @as(i64, @intCast(i)) + 10);
+    }
+
+    // Too many args.
+    var many: [256]c.Value = undefined;
+    @memset(&many, c.Void);
+    try t.eq(vm.call(func, &many, &res), c.ErrorUnknown);
+}
+
 export fn clExpandTemplateType(vm: *cy.VM, ctemplate: c.Sym, args_ptr: [*]const cy.Value, nargs: usize, res: *c.Type) bool {
     _ = vm;
     const template = cy.Sym.fromC(ctemplate).cast(.template);
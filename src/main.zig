@@ -21,6 +21,8 @@ var reload = false;
 var backend: c.Backend = c.BackendVM;
 var dumpStats = false; // Only for trace build.
 var pc: ?u32 = null;
+var profilePath: ?[]const u8 = null;
+var useProfilePath: ?[]const u8 = null;
 
 const CP_UTF8 = 65001;
 var prevWinConsoleOutputCP: u32 = undefined;
@@ -72,6 +74,22 @@ pub fn main() !void {
                     std.debug.print("Missing pc arg.\n", .{});
                     exit(1);
                 }
+            } else if (std.mem.eql(u8, arg, "-profile")) {
+                i += 1;
+                if (i < args.len) {
+                    profilePath = args[i];
+                } else {
+                    std.debug.print("Missing profile path arg.\n", .{});
+                    exit(1);
+                }
+            } else if (std.mem.eql(u8, arg, "-use-profile")) {
+                i += 1;
+                if (i < args.len) {
+                    useProfilePath = args[i];
+                } else {
+                    std.debug.print("Missing profile path arg.\n", .{});
+                    exit(1);
+                }
             } else if (std.mem.eql(u8, arg, "-h")) {
                 cmd = .help;
             } else if (std.mem.eql(u8, arg, "--help")) {
@@ -260,12 +278,30 @@ fn evalPath(alloc: std.mem.Allocator, path: []const u8) !void {
         ivm.deinit(false);
     }
 
+    var profile = cy.Profile.init();
+    defer profile.deinit(alloc);
+    if (profilePath != null) {
+        ivm.setProfile(&profile);
+    }
+
+    var hints: cy.profile.Hints = undefined;
+    if (useProfilePath) |path| {
+        hints = cy.profile.Hints.initFromPath(alloc, path) catch |err| {
+            std.debug.print("Failed to read profile {s}: {}\n", .{path, err});
+            exit(1);
+        };
+        ivm.compiler.profile_hints = &hints;
+    }
+    defer if (useProfilePath != null) hints.deinit();
+
     var config = c.defaultEvalConfig();
     config.single_run = builtin.mode == .ReleaseFast;
     config.file_modules = true;
     config.reload = reload;
     config.backend = backend;
     config.spawn_exe = true;
+    // Branch and loop sites are located through debug syms.
+    config.gen_all_debug_syms = profilePath != null;
     _ = ivm.eval(path, null, config) catch |err| {
         switch (err) {
             error.Panic => {
@@ -294,6 +330,9 @@ fn evalPath(alloc: std.mem.Allocator, path: []const u8) !void {
             exit(1);
         }
     };
+    if (profilePath) |profile_path| {
+        try profile.writeToPath(&ivm, profile_path);
+    }
     if (verbose) {
         std.debug.print("\n==VM Info==\n", .{});
         try ivm.dumpInfo();
@@ -334,6 +373,12 @@ fn help() void {
         \\General options:
         \\  -r      Refetch url imports and cached assets.
         \\  -v      Verbose.
+        \\  -profile [path]
+        \\          Write the receiver types at dynamic method call sites,
+        \\          branch bias and loop trip counts to a file. (-vm only)
+        \\  -use-profile [path]
+        \\          Lay out biased branches from a -profile file.
+        \\          (-cc and -tcc only)
         \\                            
         \\`cyber compile` options:
         \\  -pc     Next arg is the pc to dump detailed bytecode at.
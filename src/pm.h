@@ -15,7 +15,11 @@ typedef double f64;
 typedef float f32;
 
 #ifdef __TINYC__
+#define LIKELY(x) (x)
+#define UNLIKELY(x) (x)
 #else
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
 #endif
 
 typedef struct CbTypeTable CbTypeTable;
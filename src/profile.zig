@@ -0,0 +1,389 @@
+const std = @import("std");
+const stdx = @import("stdx");
+const t = stdx.testing;
+const cy = @import("cyber.zig");
+
+/// Receiver types tracked per call site before the rest are counted as `other`.
+pub const MaxSiteTypes = 4;
+
+/// Receiver type histogram of a dynamic method call site.
+pub const Site = struct {
+    types: [MaxSiteTypes]cy.TypeId,
+    counts: [MaxSiteTypes]u32,
+    len: u8,
+
+    /// Calls with a receiver type that did not fit in `types`.
+    other: u32,
+
+    fn record(self: *Site, type_id: cy.TypeId) void {
+        for (self.types[0..self.len], 0..) |id, i| {
+            if (id == type_id) {
+                self.counts[i] +|= 1;
+                return;
+            }
+        }
+        if (self.len < MaxSiteTypes) {
+            self.types[self.len] = type_id;
+            self.counts[self.len] = 1;
+            self.len += 1;
+        } else {
+            self.other +|= 1;
+        }
+    }
+
+    pub fn total(self: Site) u64 {
+        var res: u64 = self.other;
+        for (self.counts[0..self.len]) |count| {
+            res += count;
+        }
+        return res;
+    }
+};
+
+/// Condition outcomes of an `if` or `else if` branch.
+pub const Branch = struct {
+    trues: u32,
+    falses: u32,
+
+    /// Returns `true` or `false` when at least `MinBias` of the outcomes agree,
+    /// or null if the branch is unbiased or has too few samples.
+    pub fn bias(self: Branch) ?bool {
+        const total = @as(u64, self.trues) + self.falses;
+        if (total < MinBiasSamples) {
+            return null;
+        }
+        if (@as(u64, self.trues) * 100 >= total * MinBias) {
+            return true;
+        }
+        if (@as(u64, self.falses) * 100 >= total * MinBias) {
+            return false;
+        }
+        return null;
+    }
+};
+
+/// Percentage of outcomes that have to agree for a branch to be considered biased.
+pub const MinBias = 90;
+pub const MinBiasSamples = 16;
+
+/// Trip counts of a counted `for` loop.
+pub const Loop = struct {
+    /// Number of times the loop was entered, including empty ranges.
+    runs: u32,
+    /// Total number of body iterations over all runs.
+    iters: u64,
+
+    pub fn avgTrips(self: Loop) u64 {
+        if (self.runs == 0) {
+            return 0;
+        }
+        return self.iters / self.runs;
+    }
+};
+
+/// Opt-in recorder of the receiver types that flow through `CallObjSym` sites,
+/// the outcomes of `if` conditions and the trip counts of counted `for` loops.
+/// Sites are keyed by inst offset so that recording stays cheap, and are only
+/// resolved to source positions when the profile is written.
+pub const Profile = struct {
+    sites: std.AutoHashMapUnmanaged(u32, Site),
+    branches: std.AutoHashMapUnmanaged(u32, Branch),
+    loops: std.AutoHashMapUnmanaged(u32, Loop),
+
+    pub fn init() Profile {
+        return .{ .sites = .{}, .branches = .{}, .loops = .{} };
+    }
+
+    pub fn deinit(self: *Profile, alloc: std.mem.Allocator) void {
+        self.sites.deinit(alloc);
+        self.branches.deinit(alloc);
+        self.loops.deinit(alloc);
+    }
+
+    /// Inst offsets are invalidated when the VM resets its bytecode.
+    pub fn clear(self: *Profile) void {
+        self.sites.clearRetainingCapacity();
+        self.branches.clearRetainingCapacity();
+        self.loops.clearRetainingCapacity();
+    }
+
+    pub fn recordRecv(self: *Profile, alloc: std.mem.Allocator, pc_off: u32, type_id: cy.TypeId) !void {
+        const res = try self.sites.getOrPut(alloc, pc_off);
+        if (!res.found_existing) {
+            res.value_ptr.* = .{
+                .types = undefined,
+                .counts = undefined,
+                .len = 0,
+                .other = 0,
+            };
+        }
+        res.value_ptr.record(type_id);
+    }
+
+    pub fn recordBranch(self: *Profile, alloc: std.mem.Allocator, pc_off: u32, cond: bool) !void {
+        const res = try self.branches.getOrPut(alloc, pc_off);
+        if (!res.found_existing) {
+            res.value_ptr.* = .{ .trues = 0, .falses = 0 };
+        }
+        if (cond) {
+            res.value_ptr.trues +|= 1;
+        } else {
+            res.value_ptr.falses +|= 1;
+        }
+    }
+
+    /// `pc_off` is the offset of the loop's `ForRange` inst.
+    pub fn recordLoop(self: *Profile, alloc: std.mem.Allocator, pc_off: u32, runs: u32, iters: u32) !void {
+        const res = try self.loops.getOrPut(alloc, pc_off);
+        if (!res.found_existing) {
+            res.value_ptr.* = .{ .runs = 0, .iters = 0 };
+        }
+        res.value_ptr.runs +|= runs;
+        res.value_ptr.iters +|= iters;
+    }
+
+    /// Writes one line per site, ordered by source position:
+    /// `<uri>:<line>:<col> call <method> <total> <type>=<count>... [?=<other>]`
+    /// `<uri>:<line>:<col> branch <trues> <falses>`
+    /// `<uri>:<line>:<col> loop <runs> <iters>`
+    /// Receiver types are listed from most to least frequent.
+    pub fn write(self: *const Profile, vm: *cy.VM, w: anytype) !void {
+        const Entry = struct {
+            sym: cy.DebugSym,
+            data: union(enum) {
+                call: struct {
+                    method: u16,
+                    site: Site,
+                },
+                branch: Branch,
+                loop: Loop,
+            },
+
+            fn less(_: void, a: @This(), b: @This()) bool {
+                if (a.sym.file != b.sym.file) {
+                    return a.sym.file < b.sym.file;
+                }
+                return a.sym.loc < b.sym.loc;
+            }
+        };
+        var entries: std.ArrayListUnmanaged(Entry) = .{};
+        defer entries.deinit(vm.alloc);
+
+        var site_iter = self.sites.iterator();
+        while (site_iter.next()) |e| {
+            const sym = getSiteSym(vm, e.key_ptr.*) orelse continue;
+            const pc = vm.c.ops + e.key_ptr.*;
+            try entries.append(vm.alloc, .{ .sym = sym, .data = .{ .call = .{
+                .method = @as(*const align(1) u16, @ptrCast(pc + 4)).*,
+                .site = e.value_ptr.*,
+            }}});
+        }
+        var branch_iter = self.branches.iterator();
+        while (branch_iter.next()) |e| {
+            const sym = getSiteSym(vm, e.key_ptr.*) orelse continue;
+            try entries.append(vm.alloc, .{ .sym = sym, .data = .{ .branch = e.value_ptr.* }});
+        }
+        var loop_iter = self.loops.iterator();
+        while (loop_iter.next()) |e| {
+            const sym = getSiteSym(vm, e.key_ptr.*) orelse continue;
+            try entries.append(vm.alloc, .{ .sym = sym, .data = .{ .loop = e.value_ptr.* }});
+        }
+        std.sort.pdq(Entry, entries.items, {}, Entry.less);
+
+        for (entries.items) |*e| {
+            const chunk = vm.compiler.chunks.items[e.sym.file];
+            var line: u32 = undefined;
+            var col: u32 = undefined;
+            var line_start: u32 = undefined;
+            chunk.ast.computeLinePos(e.sym.loc, &line, &col, &line_start);
+            try w.print("{s}:{}:{} ", .{chunk.srcUri, line + 1, col + 1});
+
+            switch (e.data) {
+                .call => |*call| {
+                    const method_name = cy.rt.getName(vm, vm.methods.buf[call.method].name);
+                    try w.print("call {s} {}", .{method_name, call.site.total()});
+
+                    // Insertion sort by count, descending.
+                    const site = &call.site;
+                    for (1..site.len) |i| {
+                        var j = i;
+                        while (j > 0 and site.counts[j-1] < site.counts[j]) : (j -= 1) {
+                            std.mem.swap(cy.TypeId, &site.types[j-1], &site.types[j]);
+                            std.mem.swap(u32, &site.counts[j-1], &site.counts[j]);
+                        }
+                    }
+                    for (site.types[0..site.len], site.counts[0..site.len]) |type_id, count| {
+                        try w.print(" {s}={}", .{vm.getTypeName(type_id), count});
+                    }
+                    if (site.other > 0) {
+                        try w.print(" ?={}", .{site.other});
+                    }
+                },
+                .branch => |branch| {
+                    try w.print("branch {} {}", .{branch.trues, branch.falses});
+                },
+                .loop => |loop| {
+                    try w.print("loop {} {}", .{loop.runs, loop.iters});
+                },
+            }
+            try w.writeByte('\n');
+        }
+    }
+
+    fn getSiteSym(vm: *cy.VM, pc_off: u32) ?cy.DebugSym {
+        const sym = cy.debug.getDebugSymByPc(vm, pc_off) orelse return null;
+        if (sym.loc == cy.NullId) {
+            return null;
+        }
+        return sym;
+    }
+
+    pub fn writeToPath(self: *const Profile, vm: *cy.VM, path: []const u8) !void {
+        const file = try std.fs.cwd().createFile(path, .{});
+        defer file.close();
+        var buf = std.io.bufferedWriter(file.writer());
+        try self.write(vm, buf.writer());
+        try buf.flush();
+    }
+};
+
+/// The parts of a written profile that a compiler backend can use, keyed by `<uri>:<line>:<col>`.
+/// Only branch bias is used so far, by cgen's `branchHint`.
+/// Receiver type lines are skipped, since cgen does not lower `CallObjSym` yet and so has
+/// no dyn call to guard or devirtualize. Loop counts are parsed but no backend reads them yet.
+pub const Hints = struct {
+    alloc: std.mem.Allocator,
+    /// Owns the profile text that the keys point into.
+    src: []const u8,
+    branches: std.StringHashMapUnmanaged(Branch),
+    loops: std.StringHashMapUnmanaged(Loop),
+
+    pub fn init(alloc: std.mem.Allocator, src: []const u8) !Hints {
+        var new = Hints{
+            .alloc = alloc,
+            .src = try alloc.dupe(u8, src),
+            .branches = .{},
+            .loops = .{},
+        };
+        errdefer new.deinit();
+
+        var lines = std.mem.tokenizeScalar(u8, new.src, '\n');
+        while (lines.next()) |line| {
+            var parts = std.mem.tokenizeScalar(u8, line, ' ');
+            const loc = parts.next() orelse continue;
+            const kind = parts.next() orelse return error.InvalidProfile;
+            if (std.mem.eql(u8, kind, "branch")) {
+                const trues = try parseCount(u32, parts.next());
+                const falses = try parseCount(u32, parts.next());
+                try new.branches.put(alloc, loc, .{ .trues = trues, .falses = falses });
+            } else if (std.mem.eql(u8, kind, "loop")) {
+                const runs = try parseCount(u32, parts.next());
+                const iters = try parseCount(u64, parts.next());
+                try new.loops.put(alloc, loc, .{ .runs = runs, .iters = iters });
+            } else if (!std.mem.eql(u8, kind, "call")) {
+                return error.InvalidProfile;
+            }
+        }
+        return new;
+    }
+
+    pub fn initFromPath(alloc: std.mem.Allocator, path: []const u8) !Hints {
+        const src = try std.fs.cwd().readFileAlloc(alloc, path, 1e9);
+        defer alloc.free(src);
+        return init(alloc, src);
+    }
+
+    pub fn deinit(self: *Hints) void {
+        self.branches.deinit(self.alloc);
+        self.loops.deinit(self.alloc);
+        self.alloc.free(self.src);
+    }
+
+    /// Returns the recorded outcomes of the branch at `pos` in `chunk`.
+    pub fn getBranch(self: *const Hints, chunk: *cy.Chunk, pos: u32) ?Branch {
+        var buf: [512]u8 = undefined;
+        const key = fmtLoc(&buf, chunk, pos) orelse return null;
+        return self.branches.get(key);
+    }
+
+    pub fn getLoop(self: *const Hints, chunk: *cy.Chunk, pos: u32) ?Loop {
+        var buf: [512]u8 = undefined;
+        const key = fmtLoc(&buf, chunk, pos) orelse return null;
+        return self.loops.get(key);
+    }
+
+    fn fmtLoc(buf: []u8, chunk: *cy.Chunk, pos: u32) ?[]const u8 {
+        var line: u32 = undefined;
+        var col: u32 = undefined;
+        var line_start: u32 = undefined;
+        chunk.ast.computeLinePos(pos, &line, &col, &line_start);
+        return std.fmt.bufPrint(buf, "{s}:{}:{}", .{chunk.srcUri, line + 1, col + 1}) catch null;
+    }
+};
+
+fn parseCount(comptime T: type, str: ?[]const u8) !T {
+    return std.fmt.parseInt(T, str orelse return error.InvalidProfile, 10) catch return error.InvalidProfile;
+}
+
+test "Profile site histogram." {
+    var profile = Profile.init();
+    defer profile.deinit(t.alloc);
+
+    for (0..3) |_| {
+        try profile.recordRecv(t.alloc, 10, 100);
+    }
+    try profile.recordRecv(t.alloc, 10, 101);
+    for (102..106) |id| {
+        try profile.recordRecv(t.alloc, 10, @intCast(id));
+    }
+    try profile.recordRecv(t.alloc, 20, 100);
+
+    const site = profile.sites.get(10).?;
+    try t.eq(site.len, MaxSiteTypes);
+    try t.eq(site.counts[0], 3);
+    try t.eq(site.other, 2);
+    try t.eq(site.total(), 8);
+    try t.eq(profile.sites.get(20).?.total(), 1);
+
+    profile.clear();
+    try t.eq(profile.sites.count(), 0);
+}
+
+test "Profile branch and loop counts." {
+    var profile = Profile.init();
+    defer profile.deinit(t.alloc);
+
+    for (0..20) |i| {
+        try profile.recordBranch(t.alloc, 10, i != 0);
+        try profile.recordBranch(t.alloc, 20, i % 2 == 0);
+    }
+    try t.eq(profile.branches.get(10).?.trues, 19);
+    try t.eq(profile.branches.get(10).?.bias(), true);
+    try t.eq(profile.branches.get(20).?.bias(), null);
+
+    try profile.recordLoop(t.alloc, 30, 1, 1);
+    try profile.recordLoop(t.alloc, 30, 0, 9);
+    try profile.recordLoop(t.alloc, 30, 1, 0);
+    try t.eq(profile.loops.get(30).?.runs, 2);
+    try t.eq(profile.loops.get(30).?.avgTrips(), 5);
+
+    profile.clear();
+    try t.eq(profile.branches.count(), 0);
+    try t.eq(profile.loops.count(), 0);
+}
+
+test "Profile hints." {
+    var hints = try Hints.init(t.alloc,
+        \/a/main.cy:2:5 call foo 3 Foo=3
+        \/a/main.cy:3:1 branch 2 30
+        \/a/main.cy:7:1 loop 4 400
+        \
+    );
+    defer hints.deinit();
+
+    try t.eq(hints.branches.count(), 1);
+    try t.eq(hints.branches.get("/a/main.cy:3:1").?.bias(), false);
+    try t.eq(hints.loops.get("/a/main.cy:7:1").?.avgTrips(), 100);
+
+    try t.expectError(Hints.init(t.alloc, "/a/main.cy:3:1 branch 2\n"), error.InvalidProfile);
+}
@@ -53,10 +53,16 @@ const LocalVarS = struct {
     /// If declaration has an initializer.
     hasInit: bool,
 
-    /// Currently a captured var always needs to be lifted.
-    /// In the future, the concept of a immutable variable could change this.
+    /// Lifted vars live in an `UpValue` box.
+    /// Captured vars are only lifted if they are also assigned to. See `captureVar`.
     lifted: bool,
 
+    /// Whether a closure captured the var.
+    captured: bool,
+
+    /// Whether the var was assigned to after its declaration.
+    assigned: bool,
+
     /// If var is hidden, user code can not reference it.
     hidden: bool,
 
@@ -351,6 +357,18 @@ pub fn semaStmt(c: *cy.Chunk, node: *ast.Node) !void {
         },
         .assignStmt => {
             const stmt = node.cast(.assignStmt);
+            if (isSelfPlusAssign(c, stmt.left, stmt.right)) {
+                // Rewrite `a = a + b` to `a += b`.
+                const bin = stmt.right.cast(.binExpr);
+                const op_assign = try c.parser.ast.newNodeErase(.opAssignStmt, .{
+                    .left = stmt.left,
+                    .right = bin.right,
+                    .op = .plus,
+                    .assign_pos = bin.op_pos,
+                });
+                try semaStmt(c, op_assign);
+                return;
+            }
             _ = try assignStmt(c, node, stmt.left, stmt.right, .{});
         },
         .trait_decl,
@@ -1002,6 +1020,9 @@ fn assignStmt(c: *cy.Chunk, node: *ast.Node, left_n: *ast.Node, right: *ast.Node
                     return irStart;
                 },
                 .capturedLocal  => {
+                    const alias_id = c.proc().nameToVar.get(c.ast.nodeString(left_n)).?.varId;
+                    try markAssignedVar(c, c.capVarDescs.get(alias_id).?.user);
+
                     const irStart = try c.ir.pushEmptyStmt(c.alloc, .set, node);
                     c.ir.setStmtData(irStart, .set, .{ .generic = .{
                         .left_t = leftT,
@@ -1024,6 +1045,31 @@ fn assignStmt(c: *cy.Chunk, node: *ast.Node, left_n: *ast.Node, right: *ast.Node
     }
 }
 
+/// Whether `a = a + b` can be lowered as `a += b`. Only done when `a` is a local that is
+/// statically a `String`, since that is where `+=` differs by appending in place.
+fn isSelfPlusAssign(c: *cy.Chunk, left: *ast.Node, right: *ast.Node) bool {
+    if (left.type() != .ident or right.type() != .binExpr) {
+        return false;
+    }
+    const bin = right.cast(.binExpr);
+    if (bin.op != .plus or bin.left.type() != .ident) {
+        return false;
+    }
+    const name = c.ast.nodeString(left);
+    if (!std.mem.eql(u8, name, c.ast.nodeString(bin.left))) {
+        return false;
+    }
+    if (c.semaProcs.items.len == 0) {
+        return false;
+    }
+    const info = c.proc().nameToVar.get(name) orelse return false;
+    const svar = c.varStack.items[info.varId];
+    if (svar.type == .staticAlias) {
+        return false;
+    }
+    return svar.vtype.id == bt.String and !svar.vtype.dynamic;
+}
+
 fn semaIndexExpr2(c: *cy.Chunk, left: ExprResult, left_n: *ast.Node, arg0: ExprResult, arg0_n: *ast.Node, node: *ast.Node) !ExprResult {
     const leftT = left.type.id;
     if (left.type.isDynAny()) {
@@ -2857,6 +2903,8 @@ fn declareParam(c: *cy.Chunk, param: ?*ast.FuncParam, isSelf: bool, paramIdx: us
             .isParamCopied = false,
             .hasInit = false,
             .lifted = false,
+            .captured = false,
+            .assigned = false,
             .declIrStart = cy.NullId,
             .hidden = false,
         },
@@ -2922,6 +2970,8 @@ fn reserveLocalName(c: *cy.Chunk, name: []const u8, declType: TypeId, hidden: bo
         .isParamCopied = false,
         .hasInit = hasInit,
         .lifted = false,
+        .captured = false,
+        .assigned = false,
         .hidden = hidden,
         .declIrStart = cy.NullId,
     }};
@@ -4112,10 +4162,16 @@ fn pushStaticVarAlias(c: *cy.Chunk, name: []const u8, sym: *Sym) !LocalVarId {
 
 fn ensureLiftedVar(c: *cy.Chunk, var_id: LocalVarId) !void {
     const info = &c.varStack.items[var_id];
+    if (info.inner.local.lifted) {
+        return;
+    }
     info.inner.local.lifted = true;
 
-    // Patch local IR.
-    if (!info.inner.local.isParam) {
+    if (info.inner.local.isParam) {
+        // The box is created from a copy of the param.
+        info.inner.local.isParamCopied = true;
+    } else {
+        // Patch local IR.
         const loc = info.inner.local.declIrStart;
 
         if (info.inner.local.hasInit) {
@@ -4128,6 +4184,46 @@ fn ensureLiftedVar(c: *cy.Chunk, var_id: LocalVarId) !void {
     }
 }
 
+/// A var that is never assigned after its declaration is copied into the closure's
+/// captured slots by value. Otherwise, the var is lifted so that the parent and the
+/// closure share the same `UpValue`. An assignment after the capture lifts the var
+/// retroactively since bytecode is only generated after sema.
+fn captureVar(c: *cy.Chunk, var_id: LocalVarId) !void {
+    const svar = &c.varStack.items[var_id];
+    svar.inner.local.captured = true;
+    if (!canCaptureByValue(c, svar.*)) {
+        try ensureLiftedVar(c, var_id);
+    }
+}
+
+fn canCaptureByValue(c: *cy.Chunk, svar: LocalVar) bool {
+    const local = svar.inner.local;
+    if (local.assigned) {
+        return false;
+    }
+    // Vars without an initializer are written to in place. eg. A for range var.
+    if (!local.isParam and !local.hasInit) {
+        return false;
+    }
+    // Captured slots are released as boxed values.
+    if (c.sema.isUnboxedType(svar.declT)) {
+        return false;
+    }
+    // Value types can be updated in place.
+    if (c.sema.isStructType(svar.declT) or c.sema.isArrayType(svar.declT)) {
+        return false;
+    }
+    return true;
+}
+
+fn markAssignedVar(c: *cy.Chunk, var_id: LocalVarId) !void {
+    const svar = &c.varStack.items[var_id];
+    svar.inner.local.assigned = true;
+    if (svar.inner.local.captured) {
+        try ensureLiftedVar(c, var_id);
+    }
+}
+
 fn pushCapturedVar(c: *cy.Chunk, name: []const u8, parentVarId: LocalVarId, vtype: CompactType) !LocalVarId {
     const proc = c.proc();
     const id = try pushLocalVar(c, .parentLocalAlias, name, vtype.id, false);
@@ -4139,7 +4235,7 @@ fn pushCapturedVar(c: *cy.Chunk, name: []const u8, parentVarId: LocalVarId, vtyp
     };
     c.varStack.items[id].vtype = vtype;
 
-    try ensureLiftedVar(c, parentVarId);
+    try captureVar(c, parentVarId);
 
     try c.capVarDescs.put(c.alloc, id, .{
         .user = parentVarId,
@@ -4233,10 +4329,6 @@ pub fn lookupIdent(self: *cy.Chunk, name: []const u8, node: *ast.Node) !LookupId
 
         // Create a local captured variable.
         const parentVar = self.varStack.items[res.varId];
-        const resVar = &self.varStack.items[res.varId];
-        if (!resVar.inner.local.isParamCopied) {
-            resVar.inner.local.isParamCopied = true;
-        }
         const id = try pushCapturedVar(self, name, res.varId, parentVar.vtype);
         return LookupIdentResult{
             .local = id,
@@ -6678,7 +6770,14 @@ pub const ChunkExt = struct {
 
                 // Look for sym under left type's module.
                 const leftTypeSym = c.sema.getTypeSym(left.type.id);
-                const sym = try c.mustFindSym(leftTypeSym, op.name(), node);
+                var name = op.name();
+                if (op == .plus and left.type.id == bt.String and node.type() == .opAssignStmt) {
+                    // The result replaces the left operand so the string can be appended to in place.
+                    if (leftTypeSym.getMod().?.getSym("appendInPlace_") != null) {
+                        name = "appendInPlace_";
+                    }
+                }
+                const sym = try c.mustFindSym(leftTypeSym, name, node);
                 const func_sym = try requireFuncSym(c, sym, node);
                 return c.semaCallFuncSymRec(func_sym, leftId, left, 
                     &.{ rightId }, expr.getRetCstr(), node);
@@ -6910,6 +7009,8 @@ fn assignToLocalVar(c: *cy.Chunk, localRes: ExprResult, rhs: *ast.Node, opts: As
         right.irIdx = loc;
     }
 
+    try markAssignedVar(c, id);
+
     // Refresh pointer after rhs.
     svar = &c.varStack.items[id];
 
@@ -8,6 +8,7 @@ const rt = cy.rt;
 const Value = cy.Value;
 const C = @import("../capi.zig");
 const cli = @import("../cli.zig");
+const cy_mod = @import("../builtins/cy.zig");
 
 pub const File = extern struct {
     readBuf: [*]u8,
@@ -304,6 +305,22 @@ pub fn fileWrite(vm: *cy.VM) anyerror!Value {
     return Value.initInt(@intCast(numWritten));
 }
 
+pub fn fileWriteCyon(vm: *cy.VM) anyerror!Value {
+    if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
+
+    const fileo = vm.getHostObject(*File, 0);
+    if (fileo.closed) {
+        return rt.prepThrowError(vm, .Closed);
+    }
+
+    // Encode straight into a buffered file writer rather than an intermediate string.
+    var buf = std.io.bufferedWriter(fileo.getStdFile().writer());
+    var enc = cy.CyonStreamEncoder(@TypeOf(buf).Writer).init(buf.writer());
+    try cy_mod.encodeCyonValue(vm, &enc, vm.getValue(1));
+    try buf.flush();
+    return Value.Void;
+}
+
 pub fn fileClose(vm: *cy.VM) Value {
     if (!cy.hasStdFiles) return vm.prepPanic("Unsupported.");
 
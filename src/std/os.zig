@@ -78,6 +78,7 @@ const funcs = [_]C.HostFuncEntry{
     func("File.streamLines",    zErrFunc(fs.fileStreamLines)),
     func("File.streamLines2",   zErrFunc(fs.fileStreamLines1)),
     func("File.write",          zErrFunc(fs.fileWrite)),
+    func("File.writeCyon",      zErrFunc(fs.fileWriteCyon)),
 
     // Dir
     func("Dir.iterator",   fs.dirIterator),
@@ -619,6 +620,17 @@ pub fn bindLibExt(vm: *cy.VM) anyerror!Value {
     if (val.isTrue()) {
         config.gen_table = true;
     }
+    const cache_key = try vm.retainOrAllocAstring("cache");
+    defer vm.release(cache_key);
+    if (configV.asHeapObject().table.get(cache_key)) |cache_val| {
+        config.cache = cache_val.isTrue();
+    }
+    const trampolines_key = try vm.retainOrAllocAstring("trampolines");
+    defer vm.release(trampolines_key);
+    const trampolines_val = configV.asHeapObject().table.get(trampolines_key) orelse Value.True;
+    if (!trampolines_val.isTrue()) {
+        config.trampolines = false;
+    }
     return @call(.never_inline, ffi.ffiBindLib, .{vm, config});
 }
 
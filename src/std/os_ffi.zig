@@ -1,10 +1,13 @@
 const std = @import("std");
 const builtin = @import("builtin");
 const stdx = @import("stdx");
+const t = stdx.testing;
 const tcc = @import("tcc");
 const cy = @import("../cyber.zig");
 const c = @import("../capi.zig");
 const cli = @import("../cli.zig");
+const cache = @import("../cache.zig");
+const build_options = @import("build_options");
 const rt = cy.rt;
 const Value = cy.Value;
 const builtins = @import("../builtins/builtins.zig");
@@ -15,6 +18,7 @@ const os = @import("os.zig");
 const sema = cy.sema;
 const bt = cy.types.BuiltinTypes;
 const types = cy.types;
+const X64 = @import("../jit/x64.zig");
 
 const log = cy.log.scoped(.ffi);
 
@@ -161,7 +165,12 @@ pub fn ffiFinalizer(vm_: ?*c.VM, obj: ?*anyopaque) callconv(.C) void {
 const CGen = struct {
     ffi: *FFI,
 
-    pub fn genHeaders(_: CGen, w: anytype) !void {
+    /// Host functions and binded C functions are declared as function pointers
+    /// that are assigned after loading with `linkShim` instead of being resolved by TCC.
+    /// This allows the compiled shim to be saved as a shared library.
+    link_ptrs: bool = false,
+
+    pub fn genHeaders(self: CGen, w: anytype) !void {
         try w.print(
             \\#define bool _Bool
             \\#define int64_t long long
@@ -187,15 +196,30 @@ const CGen = struct {
             \\    ZAllocator alloc;
             \\    VMC c;
             \\}} VM;
-            \\extern void _cyRelease(VM*, uint64_t);
-            \\extern void* icyGetPtr(VM*, uint64_t);
-            \\extern void* _cyGetFuncPtr(VM*, uint64_t);
-            \\extern uint64_t icyAllocObject(VM*, uint32_t);
-            \\extern uint64_t icyAllocList(VM*, uint64_t*, uint32_t);
-            \\extern uint64_t cy_alloc_int(VM*, int64_t);
-            \\extern int64_t cy_as_boxint(uint64_t);
-            \\extern uint64_t icyAllocCyPointer(VM*, void*);
-            \\extern uint64_t _cyCallFunc(VM*, uint64_t, uint64_t*, uint8_t);
+            \\
+        , .{});
+        for (HostFuncs) |func| {
+            if (self.link_ptrs) {
+                try w.print("{s} (*{s})({s});\n", .{func.ret, func.name, func.params});
+            } else {
+                try w.print("extern {s} {s}({s});\n", .{func.ret, func.name, func.params});
+            }
+        }
+        if (self.link_ptrs and builtin.cpu.arch != .aarch64) {
+            // A shim library can't resolve these from the host, so it carries its own.
+            try w.print(
+                \\unsigned long long __fixunsdfdi(double a) {{
+                \\    if (a >= 9223372036854775808.0) return (unsigned long long)(long long)(a - 9223372036854775808.0) ^ 0x8000000000000000ULL;
+                \\    return (unsigned long long)(long long)a;
+                \\}}
+                \\double __floatundidf(unsigned long long a) {{
+                \\    if ((long long)a >= 0) return (double)(long long)a;
+                \\    return (double)(long long)((a >> 1) | (a & 1)) * 2.0;
+                \\}}
+                \\
+            , .{});
+        }
+        try w.print(
             \\extern int printf(char* fmt, ...);
             \\#define CALL_ARG_START 5
             \\uint64_t cy_get_value(VM* vm, size_t idx) {{
@@ -318,15 +342,22 @@ const CGen = struct {
     fn genFunc(self: *CGen, vm: *cy.VM, w: anytype, funcInfo: CFuncData, config: BindLibConfig) !void {
         _ = vm;
         var buf: [32]u8 = undefined;
-        _ = self;
+        var callee_buf: [128]u8 = undefined;
         const params = funcInfo.params;
         const sym = funcInfo.namez;
         const ret = funcInfo.ret;
 
         // Emit extern declaration.
-        try w.writeAll("extern ");
-        try writeCType(w, funcInfo.ret);
-        try w.print(" {s}(", .{ sym });
+        var callee: []const u8 = sym;
+        if (self.link_ptrs) {
+            callee = try std.fmt.bufPrint(&callee_buf, "cyfn_{s}", .{sym});
+            try writeCType(w, funcInfo.ret);
+            try w.print(" (*{s})(", .{ callee });
+        } else {
+            try w.writeAll("extern ");
+            try writeCType(w, funcInfo.ret);
+            try w.print(" {s}(", .{ sym });
+        }
         if (params.len > 0) {
             try writeCType(w, params[0]);
             if (params.len > 1) {
@@ -366,53 +397,53 @@ const CGen = struct {
 
         // Gen call.
         if (ret == .object) {
-            try w.print("  Struct{} res = {s}(", .{ret.object, sym});
+            try w.print("  Struct{} res = {s}(", .{ret.object, callee});
         } else {
             switch (ret.sym) {
                 .char => {
-                    try w.print("  int8_t res = {s}(", .{sym});
+                    try w.print("  int8_t res = {s}(", .{callee});
                 },
                 .uchar => {
-                    try w.print("  uint8_t res = {s}(", .{sym});
+                    try w.print("  uint8_t res = {s}(", .{callee});
                 },
                 .short => {
-                    try w.print("  int16_t res = {s}(", .{sym});
+                    try w.print("  int16_t res = {s}(", .{callee});
                 },
                 .ushort => {
-                    try w.print("  uint16_t res = {s}(", .{sym});
+                    try w.print("  uint16_t res = {s}(", .{callee});
                 },
                 .int => {
-                    try w.print("  int32_t res = {s}(", .{sym});
+                    try w.print("  int32_t res = {s}(", .{callee});
                 },
                 .uint => {
-                    try w.print("  uint32_t res = {s}(", .{sym});
+                    try w.print("  uint32_t res = {s}(", .{callee});
                 },
                 .long => {
-                    try w.print("  int64_t res = {s}(", .{sym});
+                    try w.print("  int64_t res = {s}(", .{callee});
                 },
                 .ulong => {
-                    try w.print("  uint64_t res = {s}(", .{sym});
+                    try w.print("  uint64_t res = {s}(", .{callee});
                 },
                 .usize => {
-                    try w.print("  size_t res = {s}(", .{sym});
+                    try w.print("  size_t res = {s}(", .{callee});
                 },
                 .float => {
-                    try w.print("  double res = (double){s}(", .{sym});
+                    try w.print("  double res = (double){s}(", .{callee});
                 },
                 .double => {
-                    try w.print("  double res = {s}(", .{sym});
+                    try w.print("  double res = {s}(", .{callee});
                 },
                 .charPtr => {
-                    try w.print("  char* res = {s}(", .{sym});
+                    try w.print("  char* res = {s}(", .{callee});
                 },
                 .voidPtr => {
-                    try w.print("  void* res = {s}(", .{sym});
+                    try w.print("  void* res = {s}(", .{callee});
                 },
                 .void => {
-                    try w.print("  {s}(", .{sym});
+                    try w.print("  {s}(", .{callee});
                 },
                 .bool => {
-                    try w.print("  bool res = {s}(", .{sym});
+                    try w.print("  bool res = {s}(", .{callee});
                 },
                 else => cy.panicFmt("Unsupported return type: {s}", .{ @tagName(ret.sym) }),
             }
@@ -501,6 +532,7 @@ pub fn ffiCfunc(vm: *cy.VM) anyerror!Value {
         .ptr = undefined,
         .funcSigId = undefined,
         .skip = false,
+        .tramp = null,
     });
 
     return Value.Void;
@@ -552,6 +584,14 @@ pub const BindLibConfig = struct {
     /// Whether bindLib generates the binding to an anonymous object type as methods
     /// or a table with functions.
     gen_table: bool = false,
+
+    /// Whether the compiled C glue is loaded from and saved to the shim cache.
+    /// Off in test builds so that test runs don't write to the user's cache.
+    cache: bool = !builtin.is_test,
+
+    /// Whether supported signatures are called through direct-call trampolines
+    /// instead of generated C wrappers.
+    trampolines: bool = true,
 };
 
 fn writeCType(w: anytype, ctype: CType) !void {
@@ -859,7 +899,7 @@ pub fn ffiBindLib(vm: *cy.VM, config: BindLibConfig) !Value {
     defer csrc.deinit(vm.alloc);
     const w = csrc.writer(vm.alloc);
 
-    var cgen = CGen{ .ffi = ffi };
+    var cgen = CGen{ .ffi = ffi, .link_ptrs = true };
 
     try cgen.genHeaders(w);
 
@@ -902,7 +942,28 @@ pub fn ffiBindLib(vm: *cy.VM, config: BindLibConfig) !Value {
 
         cfunc.ptr = ptr;
         cfunc.funcSigId = funcSigId;
-        try cgen.genFunc(vm, w, cfunc.*, config);
+        cfunc.tramp = null;
+    }
+
+    var tramps: ?*Trampolines = null;
+    defer {
+        if (!success) {
+            if (tramps) |tramps_| {
+                tramps_.deinit();
+                vm.alloc.destroy(tramps_);
+            }
+        }
+    }
+    if (TrampolinesSupported and config.trampolines) {
+        tramps = try genTrampolines(vm, ffi, config);
+    }
+
+    // C wrappers are only needed for functions without a trampoline and for struct conversions.
+    var need_shim = ffi.cstructs.items.len > 0;
+    for (ffi.cfuncs.items) |cfunc| {
+        if (cfunc.skip or cfunc.tramp != null) continue;
+        try cgen.genFunc(vm, w, cfunc, config);
+        need_shim = true;
     }
 
     for (ffi.cstructs.items) |cstruct| {
@@ -924,59 +985,36 @@ pub fn ffiBindLib(vm: *cy.VM, config: BindLibConfig) !Value {
         std.debug.print("{s}\n", .{csrc.items});
     }
 
-    const state = tcc.tcc_new();
-    // Don't include libtcc1.a.
-    _ = tcc.tcc_set_options(state, "-nostdlib");
-    _ = tcc.tcc_set_output_type(state, tcc.TCC_OUTPUT_MEMORY);
-
-    if (tcc.tcc_compile_string(state, csrc.items.ptr) == -1) {
-        cy.panic("Failed to compile c source.");
-    }
-
-    // const __floatundisf = @extern(*anyopaque, .{ .name = "__floatundisf", .linkage = .Strong });
-    if (builtin.cpu.arch != .aarch64) {
-        _ = tcc.tcc_add_symbol(state, "__fixunsdfdi", __fixunsdfdi);
-        _ = tcc.tcc_add_symbol(state, "__floatundidf", __floatundidf);
+    var shim: ?Shim = null;
+    var loaded_cached = false;
+    if (need_shim and ShimCacheSupported and config.cache) {
+        const lib_path = if (path.getValue(0).asInt() == 0) "" else path.getValue(1).asString();
+        if (openCachedShim(vm.alloc, csrc.items[0..csrc.items.len-1 :0], lib_path)) |shim_lib| {
+            shim = .{ .lib = shim_lib };
+            loaded_cached = true;
+        } else |err| {
+            log.tracev("Shim cache unavailable: {}", .{err});
+        }
     }
-    // _ = tcc.tcc_add_symbol(state, "__floatundisf", __floatundisf);
-    _ = tcc.tcc_add_symbol(state, "printf", std.c.printf);
-    // _ = tcc.tcc_add_symbol(state, "exit", std.c.exit);
-    // _ = tcc.tcc_add_symbol(state, "breakpoint", breakpoint);
-    _ = tcc.tcc_add_symbol(state, "_cyRelease", cyRelease);
-    _ = tcc.tcc_add_symbol(state, "icyGetPtr", cGetPtr);
-    _ = tcc.tcc_add_symbol(state, "cy_as_boxint", cAsBoxInt);
-    _ = tcc.tcc_add_symbol(state, "_cyGetFuncPtr", cGetFuncPtr);
-    _ = tcc.tcc_add_symbol(state, "icyAllocCyPointer", cAllocCyPointer);
-    _ = tcc.tcc_add_symbol(state, "icyAllocObject", cAllocObject);
-    _ = tcc.tcc_add_symbol(state, "cy_alloc_int", cAllocInt);
-    _ = tcc.tcc_add_symbol(state, "icyAllocList", cAllocList);
-    // _ = tcc.tcc_add_symbol(state, "printValue", cPrintValue);
-    if (builtin.cpu.arch == .aarch64) {
-        _ = tcc.tcc_add_symbol(state, "memmove", memmove);
+    if (need_shim and !loaded_cached) {
+        shim = .{ .tcc = compileShim(csrc.items[0..csrc.items.len-1 :0], true) };
     }
-
-    // Add binded symbols.
-    for (ffi.cfuncs.items) |cfunc| {
-        if (cfunc.skip) continue;
-        _ = tcc.tcc_add_symbol(state, cfunc.namez.ptr, cfunc.ptr);
-    }
-
-    if (tcc.tcc_relocate(state, tcc.TCC_RELOCATE_AUTO) < 0) {
-        cy.panic("Failed to relocate compiled code.");
+    if (shim) |shim_| {
+        try linkShim(ffi, shim_);
     }
 
     if (config.gen_table) {
         // Create map with binded C-functions as functions.
         const table = try vm.allocTable();
 
-        const cyState = try cy.heap.allocTccState(vm, state.?, lib);
+        const cyState = try allocBindState(vm, shim, lib, tramps);
 
         var numGenFuncs: u32 = 0;
         for (ffi.cfuncs.items) |cfunc| {
             if (cfunc.skip) continue;
             const symGen = try std.fmt.allocPrint(vm.alloc, "cy{s}\x00", .{cfunc.namez});
             defer vm.alloc.free(symGen);
-            const funcPtr = tcc.tcc_get_symbol(state, symGen.ptr) orelse {
+            const funcPtr = cfunc.tramp orelse shim.?.lookup(@ptrCast(symGen.ptr)) orelse {
                 cy.panic("Failed to get symbol.");
             };
 
@@ -997,7 +1035,7 @@ pub fn ffiBindLib(vm: *cy.VM, config: BindLibConfig) !Value {
             const typeName = vm.getTypeName(cstruct.type);
             const symGen = try std.fmt.allocPrint(vm.alloc, "cyPtrTo{s}{u}", .{typeName, 0});
             defer vm.alloc.free(symGen);
-            const funcPtr = tcc.tcc_get_symbol(state, symGen.ptr) orelse {
+            const funcPtr = shim.?.lookup(@ptrCast(symGen.ptr)) orelse {
                 cy.panic("Failed to get symbol.");
             };
 
@@ -1021,12 +1059,12 @@ pub fn ffiBindLib(vm: *cy.VM, config: BindLibConfig) !Value {
         const tccField = try vm.ensureField("tcc");
         try vm.addTypeField(sid, tccField, 0, bt.Any);
 
-        const cyState = try cy.heap.allocTccState(vm, state.?, lib);
+        const cyState = try allocBindState(vm, shim, lib, tramps);
         for (ffi.cfuncs.items) |cfunc| {
             if (cfunc.skip) continue;
             const cySym = try std.fmt.allocPrint(vm.alloc, "cy{s}\x00", .{cfunc.namez});
             defer vm.alloc.free(cySym);
-            const funcPtr = tcc.tcc_get_symbol(state, cySym.ptr) orelse {
+            const funcPtr = cfunc.tramp orelse shim.?.lookup(@ptrCast(cySym.ptr)) orelse {
                 cy.panic("Failed to get symbol.");
             };
 
@@ -1042,7 +1080,7 @@ pub fn ffiBindLib(vm: *cy.VM, config: BindLibConfig) !Value {
             const typeName = vm.getTypeName(cstruct.type);
             const symGen = try std.fmt.allocPrint(vm.alloc, "cyPtrTo{s}{u}", .{typeName, 0});
             defer vm.alloc.free(symGen);
-            const funcPtr = tcc.tcc_get_symbol(state, symGen.ptr) orelse {
+            const funcPtr = shim.?.lookup(@ptrCast(symGen.ptr)) orelse {
                 cy.panic("Failed to get symbol.");
             };
             const func = cy.ptrAlignCast(cy.ZHostFuncFn, funcPtr);
@@ -1071,8 +1109,297 @@ const CFuncData = struct {
     ptr: *anyopaque,
     funcSigId: cy.sema.FuncSigId,
     skip: bool,
+    /// Direct-call trampoline. Used instead of the generated C wrapper when set.
+    tramp: ?*anyopaque,
+};
+
+/// Direct-call trampolines are only generated for the x64 System V ABI.
+const TrampolinesSupported = builtin.cpu.arch == .x86_64 and builtin.os.tag != .windows;
+
+/// Executable memory for the direct-call trampolines of a `bindLib` call.
+/// The code lives in its own page-rounded mapping so that changing its protection
+/// can't affect memory owned by the allocator.
+pub const Trampolines = struct {
+    code: []align(std.mem.page_size) u8,
+
+    pub fn deinit(self: *Trampolines) void {
+        std.posix.munmap(self.code);
+    }
 };
 
+fn isTrampolineType(ctype: CType, is_ret: bool) bool {
+    if (ctype != .sym) {
+        return false;
+    }
+    return switch (ctype.sym) {
+        // Passed and returned as the raw int value.
+        .int, .uint, .long, .ulong, .usize => true,
+        .void => is_ret,
+        else => false,
+    };
+}
+
+/// Whether a C function can be called from a trampoline instead of a generated C wrapper.
+/// Only integer arguments that fit in registers are supported.
+fn canUseTrampoline(cfunc: CFuncData) bool {
+    if (cfunc.params.len > TrampolineArgRegs.len) {
+        return false;
+    }
+    for (cfunc.params) |param| {
+        if (!isTrampolineType(param, false)) {
+            return false;
+        }
+    }
+    return isTrampolineType(cfunc.ret, true);
+}
+
+const TrampolineArgRegs = [_]X64.Register{ .rdi, .rsi, .rdx, .rcx, .r8, .r9 };
+
+/// Emits a host function that loads the C arguments straight from the call frame
+/// and calls `cfunc.ptr`. Returns the offset of the trampoline in `enc.buf`.
+fn genTrampoline(enc: X64.Encoder, cfunc: CFuncData, is_method: bool) !usize {
+    const start = enc.buf.items.len;
+    const fp_offset = @offsetOf(cy.VM, "c") + @offsetOf(std.meta.FieldType(cy.VM, .c), "framePtr");
+    const arg_start: i32 = cy.vm.CallArgStart + @intFromBool(is_method);
+    const tail_call = cfunc.ret.sym != .int and cfunc.ret.sym != .uint and cfunc.ret.sym != .void;
+
+    if (!tail_call) {
+        // Align the stack for the call.
+        try enc.pushReg(.rax);
+    }
+
+    // rax = vm.c.framePtr
+    try enc.movMem(.rax, X64.Memory.sibBase(X64.Base.reg(.rdi), fp_offset));
+
+    // Load `rdi` last since it holds the VM.
+    var i: usize = cfunc.params.len;
+    while (i > 0) {
+        i -= 1;
+        const disp = (arg_start + @as(i32, @intCast(i))) * 8;
+        try enc.movMem(TrampolineArgRegs[i], X64.Memory.sibBase(X64.Base.reg(.rax), disp));
+    }
+
+    try enc.movImm(.r11, @intFromPtr(cfunc.ptr));
+    if (tail_call) {
+        // 64-bit int results are already a Cyber `int`.
+        try enc.jumpReg(.r11);
+        return start;
+    }
+
+    try enc.callReg(.r11);
+    try enc.popReg(.rcx);
+    switch (cfunc.ret.sym) {
+        .int => try enc.movsxd(.rax, .rax),
+        .uint => try enc.movReg32(.rax, .rax),
+        .void => try enc.movImm(.rax, Value.Void.val),
+        else => unreachable,
+    }
+    try enc.ret();
+    return start;
+}
+
+/// Generates trampolines for the eligible functions in `ffi.cfuncs` and sets `cfunc.tramp`.
+/// Returns null if no function was eligible.
+fn genTrampolines(vm: *cy.VM, ffi: *FFI, config: BindLibConfig) !?*Trampolines {
+    var offsets: std.BoundedArray(struct { idx: usize, offset: usize }, 256) = .{};
+
+    var buf: std.ArrayListAlignedUnmanaged(u8, std.mem.page_size) = .{};
+    defer buf.deinit(vm.alloc);
+    const enc = X64.Encoder{ .alloc = vm.alloc, .buf = &buf };
+
+    for (ffi.cfuncs.items, 0..) |*cfunc, idx| {
+        cfunc.tramp = null;
+        if (cfunc.skip or !canUseTrampoline(cfunc.*) or offsets.len == offsets.capacity()) {
+            continue;
+        }
+        const offset = try genTrampoline(enc, cfunc.*, !config.gen_table);
+        offsets.appendAssumeCapacity(.{ .idx = idx, .offset = offset });
+    }
+    if (offsets.len == 0) {
+        return null;
+    }
+
+    // Copy the encoded code to a private mapping before making it executable.
+    const len = std.mem.alignForward(usize, buf.items.len, std.mem.page_size);
+    const code = try std.posix.mmap(null, len, std.posix.PROT.READ | std.posix.PROT.WRITE,
+        .{ .TYPE = .PRIVATE, .ANONYMOUS = true }, -1, 0);
+    errdefer std.posix.munmap(code);
+    @memcpy(code[0..buf.items.len], buf.items);
+    try std.posix.mprotect(code, std.posix.PROT.READ | std.posix.PROT.EXEC);
+
+    const tramps = try vm.alloc.create(Trampolines);
+    tramps.* = .{ .code = code };
+    for (offsets.slice()) |entry| {
+        ffi.cfuncs.items[entry.idx].tramp = code.ptr + entry.offset;
+    }
+    return tramps;
+}
+
+const HostFunc = struct {
+    name: [:0]const u8,
+    ret: []const u8,
+    params: []const u8,
+    ptr: *const anyopaque,
+};
+
+/// Host functions that generated C code can call.
+const HostFuncs = [_]HostFunc{
+    .{ .name = "_cyRelease", .ret = "void", .params = "VM*, uint64_t", .ptr = @ptrCast(&cyRelease) },
+    .{ .name = "icyGetPtr", .ret = "void*", .params = "VM*, uint64_t", .ptr = @ptrCast(&cGetPtr) },
+    .{ .name = "_cyGetFuncPtr", .ret = "void*", .params = "VM*, uint64_t", .ptr = @ptrCast(&cGetFuncPtr) },
+    .{ .name = "icyAllocObject", .ret = "uint64_t", .params = "VM*, uint32_t", .ptr = @ptrCast(&cAllocObject) },
+    .{ .name = "icyAllocList", .ret = "uint64_t", .params = "VM*, uint64_t*, uint32_t", .ptr = @ptrCast(&cAllocList) },
+    .{ .name = "cy_alloc_int", .ret = "uint64_t", .params = "VM*, int64_t", .ptr = @ptrCast(&cAllocInt) },
+    .{ .name = "cy_as_boxint", .ret = "int64_t", .params = "uint64_t", .ptr = @ptrCast(&cAsBoxInt) },
+    .{ .name = "icyAllocCyPointer", .ret = "uint64_t", .params = "VM*, void*", .ptr = @ptrCast(&cAllocCyPointer) },
+    .{ .name = "_cyCallFunc", .ret = "uint64_t", .params = "VM*, uint64_t, uint64_t*, uint8_t", .ptr = @ptrCast(&cyCallFunc) },
+};
+
+/// Shims are cached as ELF shared libraries which are only loaded through libc's `dlopen`.
+const ShimCacheSupported = builtin.os.tag == .linux and builtin.link_libc;
+
+/// Compiled C glue for a `bindLib` call.
+const Shim = union(enum) {
+    /// Compiled in memory by TCC.
+    tcc: *tcc.TCCState,
+    /// Loaded from the shim cache.
+    lib: *std.DynLib,
+
+    fn lookup(self: Shim, name: [*:0]const u8) ?*anyopaque {
+        switch (self) {
+            .tcc => |state| return tcc.tcc_get_symbol(state, name),
+            .lib => |lib| return lib.lookup(*anyopaque, std.mem.span(name)),
+        }
+    }
+};
+
+/// The returned state owns the shim, `lib` and the trampolines.
+fn allocBindState(vm: *cy.VM, shim: ?Shim, lib: *std.DynLib, tramps: ?*Trampolines) !Value {
+    var state: ?*tcc.TCCState = null;
+    var shim_lib: ?*std.DynLib = null;
+    if (shim) |shim_| {
+        switch (shim_) {
+            .tcc => |tcc_state| state = tcc_state,
+            .lib => |lib_| shim_lib = lib_,
+        }
+    }
+    const res = try cy.heap.allocTccState(vm, state, lib);
+    res.asHeapObject().tccState.shim = shim_lib;
+    res.asHeapObject().tccState.trampolines = tramps;
+    return res;
+}
+
+/// Compiles C source in memory.
+/// When `link_ptrs` is false, host functions are resolved by TCC.
+fn compileShim(src: [:0]const u8, link_ptrs: bool) *tcc.TCCState {
+    const state = tcc.tcc_new();
+    // Don't include libtcc1.a.
+    _ = tcc.tcc_set_options(state, "-nostdlib");
+    _ = tcc.tcc_set_output_type(state, tcc.TCC_OUTPUT_MEMORY);
+
+    if (tcc.tcc_compile_string(state, src.ptr) == -1) {
+        cy.panic("Failed to compile c source.");
+    }
+
+    // const __floatundisf = @extern(*anyopaque, .{ .name = "__floatundisf", .linkage = .Strong });
+    if (!link_ptrs and builtin.cpu.arch != .aarch64) {
+        _ = tcc.tcc_add_symbol(state, "__fixunsdfdi", __fixunsdfdi);
+        _ = tcc.tcc_add_symbol(state, "__floatundidf", __floatundidf);
+    }
+    // _ = tcc.tcc_add_symbol(state, "__floatundisf", __floatundisf);
+    _ = tcc.tcc_add_symbol(state, "printf", std.c.printf);
+    // _ = tcc.tcc_add_symbol(state, "exit", std.c.exit);
+    // _ = tcc.tcc_add_symbol(state, "breakpoint", breakpoint);
+    if (!link_ptrs) {
+        for (HostFuncs) |func| {
+            _ = tcc.tcc_add_symbol(state, func.name.ptr, func.ptr);
+        }
+    }
+    // _ = tcc.tcc_add_symbol(state, "printValue", cPrintValue);
+    if (builtin.cpu.arch == .aarch64) {
+        _ = tcc.tcc_add_symbol(state, "memmove", memmove);
+    }
+
+    if (tcc.tcc_relocate(state, tcc.TCC_RELOCATE_AUTO) < 0) {
+        cy.panic("Failed to relocate compiled code.");
+    }
+    return state.?;
+}
+
+/// Assigns the function pointers declared by a `CGen` with `link_ptrs`.
+fn linkShim(ffi: *FFI, shim: Shim) !void {
+    for (HostFuncs) |func| {
+        const slot = shim.lookup(func.name.ptr) orelse return error.MissingSymbol;
+        @as(*?*const anyopaque, @ptrCast(@alignCast(slot))).* = func.ptr;
+    }
+    var buf: [128]u8 = undefined;
+    for (ffi.cfuncs.items) |cfunc| {
+        if (cfunc.skip) continue;
+        const name = try std.fmt.bufPrintZ(&buf, "cyfn_{s}", .{cfunc.namez});
+        const slot = shim.lookup(name.ptr) orelse return error.MissingSymbol;
+        @as(*?*const anyopaque, @ptrCast(@alignCast(slot))).* = cfunc.ptr;
+    }
+}
+
+/// Returns the cache key for a shim. The key covers the generated source, which
+/// reflects every `cfunc` and `cbind` declaration, and the library's path, size and modification time.
+fn shimCacheKey(src: []const u8, lib_path: []const u8) [16]u8 {
+    var hasher = std.hash.Wyhash.init(0);
+    hasher.update(build_options.full_version);
+    hasher.update(@tagName(builtin.cpu.arch));
+    hasher.update(src);
+    hasher.update(lib_path);
+    if (lib_path.len > 0) {
+        if (std.fs.cwd().statFile(lib_path)) |stat| {
+            hasher.update(std.mem.asBytes(&stat.size));
+            hasher.update(std.mem.asBytes(&stat.mtime));
+        } else |_| {
+            // Not a file path. Library is resolved from the search paths.
+        }
+    }
+    var buf: [16]u8 = undefined;
+    _ = std.fmt.bufPrint(&buf, "{x:0>16}", .{hasher.final()}) catch unreachable;
+    return buf;
+}
+
+/// Loads the shim for `src` from the cache. On a miss, the shim is first compiled to a shared library.
+fn openCachedShim(alloc: std.mem.Allocator, src: [:0]const u8, lib_path: []const u8) !*std.DynLib {
+    const key = shimCacheKey(src, lib_path);
+    const path = try cache.getFfiShimPath(alloc, &key);
+    defer alloc.free(path);
+
+    std.fs.cwd().access(path, .{}) catch |err| {
+        if (err != error.FileNotFound) {
+            return err;
+        }
+        log.tracev("Compiling shim: {s}", .{path});
+
+        // Write to a temporary file first so concurrent processes never load a partial shim.
+        const tmp_path = try std.fmt.allocPrintZ(alloc, "{s}.{}.tmp", .{path, std.c.getpid()});
+        defer alloc.free(tmp_path);
+
+        const state = tcc.tcc_new();
+        defer tcc.tcc_delete(state);
+        _ = tcc.tcc_set_options(state, "-nostdlib");
+        _ = tcc.tcc_set_output_type(state, tcc.TCC_OUTPUT_DLL);
+        if (tcc.tcc_compile_string(state, src.ptr) == -1) {
+            return error.CompileShim;
+        }
+        if (tcc.tcc_output_file(state, tmp_path.ptr) == -1) {
+            return error.CompileShim;
+        }
+        std.fs.cwd().rename(tmp_path, path) catch |rename_err| {
+            std.fs.cwd().deleteFile(tmp_path) catch {};
+            return rename_err;
+        };
+    };
+
+    const lib = try alloc.create(std.DynLib);
+    errdefer alloc.destroy(lib);
+    lib.* = try dlopen(path);
+    return lib;
+}
+
 fn dlopen(path: []const u8) !std.DynLib {
     if (builtin.os.tag == .linux and builtin.link_libc) {
         const path_c = try std.posix.toPosixPath(path);
@@ -1244,42 +1571,9 @@ pub fn ffiBindCallback(vm: *cy.VM) anyerror!Value {
         std.debug.print("{s}\n", .{csrc.items});
     }
 
-    const state = tcc.tcc_new();
-    // Don't include libtcc1.a.
-    _ = tcc.tcc_set_options(state, "-nostdlib");
-    _ = tcc.tcc_set_output_type(state, tcc.TCC_OUTPUT_MEMORY);
+    const state = compileShim(csrc.items[0..csrc.items.len-1 :0], false);
 
-    if (tcc.tcc_compile_string(state, csrc.items.ptr) == -1) {
-        cy.panic("Failed to compile c source.");
-    }
-
-    // const __floatundisf = @extern(*anyopaque, .{ .name = "__floatundisf", .linkage = .Strong });
-    if (builtin.cpu.arch != .aarch64) {
-        _ = tcc.tcc_add_symbol(state, "__fixunsdfdi", __fixunsdfdi);
-        _ = tcc.tcc_add_symbol(state, "__floatundidf", __floatundidf);
-    }
-    // _ = tcc.tcc_add_symbol(state, "__floatundisf", __floatundisf);
-    _ = tcc.tcc_add_symbol(state, "printf", std.c.printf);
-    // _ = tcc.tcc_add_symbol(state, "exit", std.c.exit);
-    // _ = tcc.tcc_add_symbol(state, "breakpoint", breakpoint);
-    _ = tcc.tcc_add_symbol(state, "icyGetPtr", cGetPtr);
-    _ = tcc.tcc_add_symbol(state, "cy_as_boxint", cAsBoxInt);
-    _ = tcc.tcc_add_symbol(state, "icyAllocCyPointer", cAllocCyPointer);
-    _ = tcc.tcc_add_symbol(state, "icyAllocObject", cAllocObject);
-    _ = tcc.tcc_add_symbol(state, "icyAllocList", cAllocList);
-    _ = tcc.tcc_add_symbol(state, "cy_alloc_int", cAllocInt);
-    _ = tcc.tcc_add_symbol(state, "_cyCallFunc", cyCallFunc);
-    _ = tcc.tcc_add_symbol(state, "_cyRelease", cyRelease);
-    // _ = tcc.tcc_add_symbol(state, "printValue", cPrintValue);
-    if (builtin.cpu.arch == .aarch64) {
-        _ = tcc.tcc_add_symbol(state, "memmove", memmove);
-    }
-
-    if (tcc.tcc_relocate(state, tcc.TCC_RELOCATE_AUTO) < 0) {
-        cy.panic("Failed to relocate compiled code.");
-    }
-
-    const tccState = try cy.heap.allocTccState(vm, state.?, null);
+    const tccState = try cy.heap.allocTccState(vm, state, null);
 
     const funcPtr = tcc.tcc_get_symbol(state, "cyExternFunc") orelse {
         cy.panic("Failed to get symbol.");
@@ -1328,3 +1622,74 @@ pub fn ffiUnbindObjPtr(vm: *cy.VM) anyerror!Value {
 
     return Value.Void;
 }
+
+test "FFI shim cache." {
+    if (!ShimCacheSupported or !cy.hasFFI) return error.SkipZigTest;
+
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+    var dir_buf: [std.fs.MAX_PATH_BYTES]u8 = undefined;
+    cache.FfiShimDirOverride = try tmp.dir.realpath(".", &dir_buf);
+    defer cache.FfiShimDirOverride = null;
+
+    const alloc = std.testing.allocator;
+    const S = struct {
+        fn callGet(lib: *std.DynLib) i32 {
+            const get = lib.lookup(*const fn () callconv(.C) i32, "get").?;
+            return get();
+        }
+
+        fn shimInode(alloc_: std.mem.Allocator, src: []const u8, lib_path: []const u8) !std.fs.File.INode {
+            const path = try cache.getFfiShimPath(alloc_, &shimCacheKey(src, lib_path));
+            defer alloc_.free(path);
+            return (try std.fs.cwd().statFile(path)).inode;
+        }
+
+        fn countShims(dir: std.fs.Dir) !usize {
+            var iter_dir = try dir.openDir(".", .{ .iterate = true });
+            defer iter_dir.close();
+            var iter = iter_dir.iterate();
+            var n: usize = 0;
+            while (try iter.next()) |_| n += 1;
+            return n;
+        }
+    };
+
+    // Miss compiles the shim into the cache dir.
+    const src1 = "int get() { return 1; }";
+    var lib = try openCachedShim(alloc, src1, "");
+    try t.eq(S.callGet(lib), 1);
+    lib.close();
+    alloc.destroy(lib);
+    try t.eq(try S.countShims(tmp.dir), 1);
+    const inode = try S.shimInode(alloc, src1, "");
+
+    // Hit loads the same file without recompiling.
+    lib = try openCachedShim(alloc, src1, "");
+    try t.eq(S.callGet(lib), 1);
+    lib.close();
+    alloc.destroy(lib);
+    try t.eq(try S.countShims(tmp.dir), 1);
+    try t.eq(try S.shimInode(alloc, src1, ""), inode);
+
+    // Changed declarations produce a different shim.
+    const src2 = "int get() { return 2; }";
+    lib = try openCachedShim(alloc, src2, "");
+    try t.eq(S.callGet(lib), 2);
+    lib.close();
+    alloc.destroy(lib);
+    try t.eq(try S.countShims(tmp.dir), 2);
+
+    // A changed library file invalidates the shim.
+    try tmp.dir.writeFile("lib.so", "a");
+    var lib_buf: [std.fs.MAX_PATH_BYTES]u8 = undefined;
+    const lib_path = try tmp.dir.realpath("lib.so", &lib_buf);
+    const key = shimCacheKey(src1, lib_path);
+    try tmp.dir.writeFile("lib.so", "ab");
+    try t.expect(!std.mem.eql(u8, &key, &shimCacheKey(src1, lib_path)));
+    lib = try openCachedShim(alloc, src1, lib_path);
+    lib.close();
+    alloc.destroy(lib);
+    // lib.so and 3 shims.
+    try t.eq(try S.countShims(tmp.dir), 4);
+}
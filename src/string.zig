@@ -64,13 +64,27 @@ pub const HeapStringBuilder = struct {
         return slice.asHeapObject();
     }
 
+    /// Like `build` except the buffer becomes the string object itself instead of the parent of a slice.
+    pub fn buildOwned(self: *HeapStringBuilder) !cy.Value {
+        self.hasObject = false;
+        return cy.heap.ownStringBuffer(self.vm, self.buf_obj, self.len, self.isAstring);
+    }
+
     pub fn appendString(self: *HeapStringBuilder, str: []const u8) !void {
+        try self.appendString2(str, cy.string.isAstring(str));
+    }
+
+    /// Appends `str` when the caller already knows whether it is ASCII.
+    pub fn appendString2(self: *HeapStringBuilder, str: []const u8, append_ascii: bool) !void {
         try self.ensureTotalCapacity(self.len + str.len);
         const oldLen = self.len;
         self.len += @intCast(str.len);
         @memcpy(self.buf[oldLen..self.len], str);
-        const append_ascii = cy.string.isAstring(str);
         if (self.isAstring and !append_ascii) {
+            if (self.buf.len <= cy.MaxPoolObjectStringByteLen) {
+                // A pool object can't hold a Ustring of this length, move to an external buffer.
+                try self.growTotalCapacity(self.buf.len + 1);
+            }
             // Upgrade to Ustring.
             const len = self.buf_obj.string.len();
             self.buf_obj.string.headerAndLen = (@as(u32, @intFromEnum(cy.heap.StringType.ustring)) << 30) | len;
@@ -85,11 +99,14 @@ pub const HeapStringBuilder = struct {
     }
 
     pub fn growTotalCapacityPrecise(self: *HeapStringBuilder, newCap: usize) !void {
+        if (newCap > cy.heap.MaxStringByteLen) {
+            return error.StringTooLong;
+        }
         const new_obj = try cy.heap.allocExternalObject(self.vm, 12 + newCap, false);
         new_obj.string = .{
             .typeId = bt.String,
             .rc = 1,
-            .headerAndLen = (@as(u32, @intFromEnum(self.buf_obj.string.getType())) << 30) | @as(u30, @intCast(newCap)),
+            .headerAndLen = (@as(u32, @intFromEnum(self.buf_obj.string.getType())) << 30) | @as(u29, @intCast(newCap)),
         };
         const new_buf = new_obj.astring.getMutSlice();
         @memcpy(new_buf[0..self.len], self.buf[0..self.len]);
@@ -99,15 +116,13 @@ pub const HeapStringBuilder = struct {
         self.buf = new_buf;
     }
 
+    /// Grows to a power of two so that `buildOwned` can hand the buffer over as a growable string.
+    /// The capacity is clamped to `MaxStringByteLen` since it's stored as the buffer's string length.
     pub fn growTotalCapacity(self: *HeapStringBuilder, newCap: usize) !void {
-        var betterCap = self.buf.len;
-        while (true) {
-            betterCap +|= betterCap / 2 + 8;
-            if (betterCap >= newCap) {
-                break;
-            }
+        if (newCap > cy.heap.MaxStringByteLen) {
+            return error.StringTooLong;
         }
-        try self.growTotalCapacityPrecise(betterCap);
+        try self.growTotalCapacityPrecise(@min(std.math.ceilPowerOfTwoAssert(usize, newCap), cy.heap.MaxStringByteLen));
     }
 };
 
@@ -218,6 +233,65 @@ pub fn ustringSeekByRuneIndex(str: []const u8, byte_idx: u32, rune_idx: u32, tar
     }
 }
 
+/// Ustrings at least this many bytes get a checkpoint index on their first rune seek.
+pub const RuneIndexMinByteLen = 4096;
+
+/// Number of runes between checkpoints.
+pub const RuneIndexStride = 64;
+
+/// Lazily built rune to byte offset index for a large ustring.
+/// `checkpoints[i]` is the byte offset of rune `i * RuneIndexStride`
+/// so a seek scans at most `RuneIndexStride - 1` runes.
+pub const RuneIndex = struct {
+    checkpoints: []u32,
+    num_runes: u32,
+
+    pub fn init(alloc: std.mem.Allocator, str: []const u8) !RuneIndex {
+        var checkpoints: std.ArrayListUnmanaged(u32) = .{};
+        errdefer checkpoints.deinit(alloc);
+        try checkpoints.ensureTotalCapacity(alloc, str.len / (RuneIndexStride * 2) + 1);
+
+        var i: usize = 0;
+        var rune_idx: u32 = 0;
+        while (i < str.len) {
+            if (rune_idx % RuneIndexStride == 0) {
+                try checkpoints.append(alloc, @intCast(i));
+            }
+            // Same stepping as `ustringSeekByRuneIndex` so both agree on invalid bytes.
+            const len = std.unicode.utf8ByteSequenceLength(str[i]) catch 1;
+            i += len;
+            rune_idx += 1;
+        }
+        return .{
+            .checkpoints = try checkpoints.toOwnedSlice(alloc),
+            .num_runes = rune_idx,
+        };
+    }
+
+    pub fn deinit(self: *RuneIndex, alloc: std.mem.Allocator) void {
+        alloc.free(self.checkpoints);
+    }
+
+    pub fn seek(self: *const RuneIndex, str: []const u8, target_rune_idx: u32, out_bad_byte: *bool) !usize {
+        if (target_rune_idx > self.num_runes) {
+            return error.OutOfBounds;
+        }
+        if (target_rune_idx == self.num_runes) {
+            out_bad_byte.* = false;
+            return str.len;
+        }
+        const cp = target_rune_idx / RuneIndexStride;
+        return ustringSeekByRuneIndex(str, self.checkpoints[cp], cp * RuneIndexStride, target_rune_idx, out_bad_byte);
+    }
+};
+
+/// Last rune seek on a ustring. Sequential access resumes from here instead of byte 0.
+pub const RuneCursor = struct {
+    obj: ?*anyopaque,
+    byte_idx: u32,
+    rune_idx: u32,
+};
+
 fn indexOfCharScalar(buf: []const u8, needle: u8) ?usize {
     for (buf, 0..) |ch, i| {
         if (ch == needle) {
@@ -767,4 +841,32 @@ const ReplacementCharSlice = &.{0xEF, 0xBF, 0xBD};
 
 pub fn getStaticUstringHeader(vm: *cy.VM, start: usize) *align(1) cy.StaticUstringHeader {
     return @ptrCast(vm.strBuf.ptr + start - 12);
-}
\ No newline at end of file
+}
+test "RuneIndex" {
+    var buf: std.ArrayListUnmanaged(u8) = .{};
+    defer buf.deinit(t.alloc);
+    for (0..300) |i| {
+        if (i % 3 == 0) {
+            try buf.appendSlice(t.alloc, "🦊");
+        } else if (i % 3 == 1) {
+            try buf.appendSlice(t.alloc, "é");
+        } else {
+            try buf.append(t.alloc, 'a');
+        }
+    }
+    // Invalid byte counts as one rune.
+    try buf.append(t.alloc, 0xff);
+    try buf.append(t.alloc, 'z');
+
+    var index = try RuneIndex.init(t.alloc, buf.items);
+    defer index.deinit(t.alloc);
+    try t.eq(index.num_runes, 302);
+    try t.eq(index.checkpoints.len, 5);
+
+    var bad_byte: bool = undefined;
+    for (0..303) |i| {
+        const exp = try ustringSeekByRuneIndex(buf.items, 0, 0, @intCast(i), &bad_byte);
+        try t.eq(try index.seek(buf.items, @intCast(i), &bad_byte), exp);
+    }
+    try t.expectError(index.seek(buf.items, 303, &bad_byte), error.OutOfBounds);
+}
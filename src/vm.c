@@ -294,7 +294,7 @@ static inline ValueResult allocTrait(VM* vm, TypeId typeId, u16 vtable, Value im
         .typeId = typeId | CYC_TYPE_MASK,
         .rc = 1,
         .impl = impl,
-        .vtable = vtable,
+        .vtable = ((ZSlice*)vm->c.vtables.buf)[vtable].ptr,
     };
     return (ValueResult){ .val = VALUE_CYC_PTR(res.obj), .code = RES_CODE_SUCCESS };
 }
@@ -639,6 +639,7 @@ ResultCode execBytecode(VM* vm) {
         JENTRY(SetUpValue),
         JENTRY(UpValue),
         JENTRY(Captured),
+        JENTRY(CapturedValue),
         JENTRY(SetCaptured),
         JENTRY(TagLit),
         JENTRY(Enum),
@@ -1023,6 +1024,9 @@ beginSwitch:
         }
 #endif
         bool cond = VALUE_AS_BOOLEAN(condv);
+        if (UNLIKELY(vm->c.profiling)) {
+            zProfileBranch(vm, pc, cond);
+        }
         if (!cond) {
             pc += READ_U16(2);
             NEXT();
@@ -1904,6 +1908,23 @@ beginSwitch:
         pc += 5;
         NEXT();
     }
+    CASE(CapturedValue): {
+        Value closure = stack[pc[1]];
+#if TRACE
+        if (!VALUE_IS_CLOSURE(vm, closure)) {
+            TRACEV("Expected closure value.");
+            zFatal();
+        }
+#endif
+        Value val = closureGetCapturedValuesPtr(&VALUE_AS_HEAPOBJECT(closure)->func_union)[pc[2]];
+        bool retain_flag = pc[3];
+        if (retain_flag) {
+            retain(vm, val);
+        }
+        stack[pc[4]] = val;
+        pc += 5;
+        NEXT();
+    }
     CASE(SetCaptured): {
         Value closure = stack[pc[1]];
 #if TRACE
@@ -2036,6 +2057,10 @@ beginSwitch:
         stack[pc[4]] = start;
         stack[pc[5]] = start;
         u16 offset = READ_U16(6);
+        if (UNLIKELY(vm->c.profiling)) {
+            bool empty = increment ? start >= end : start <= end;
+            zProfileLoop(vm, pc + offset, 1, empty ? 0 : 1);
+        }
         if (increment) {
             if (start >= end) {
                 pc += offset + 6;
@@ -2055,6 +2080,9 @@ beginSwitch:
     CASE(ForRange): {
         i64 counter = BITCAST(i64, stack[pc[1]]) + 1;
         if (counter < BITCAST(i64, stack[pc[2]])) {
+            if (UNLIKELY(vm->c.profiling)) {
+                zProfileLoop(vm, pc, 0, 1);
+            }
             stack[pc[1]] = counter;
             stack[pc[3]] = counter;
             pc -= READ_U16(4);
@@ -2066,6 +2094,9 @@ beginSwitch:
     CASE(ForRangeReverse): {
         i64 counter = BITCAST(i64, stack[pc[1]]) - 1;
         if (counter > BITCAST(i64, stack[pc[2]])) {
+            if (UNLIKELY(vm->c.profiling)) {
+                zProfileLoop(vm, pc, 0, 1);
+            }
             stack[pc[1]] = counter;
             stack[pc[3]] = counter;
             pc -= READ_U16(4);
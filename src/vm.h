@@ -332,6 +332,7 @@ typedef enum {
     CodeSetUpValue,
     CodeUpValue,
     CodeCaptured,
+    CodeCapturedValue,
     CodeSetCaptured,
     CodeTagLit,
     CodeEnum,
@@ -532,6 +533,11 @@ typedef struct ZCyList {
     size_t len;
 } ZCyList;
 
+typedef struct ZSlice {
+    void* ptr;
+    size_t len;
+} ZSlice;
+
 typedef struct Object {
     TypeId typeId;
     uint32_t rc;
@@ -542,7 +548,8 @@ typedef struct Trait {
     TypeId typeId;
     uint32_t rc;
     Value impl;
-    u32 vtable;
+    // FuncSymbol*
+    void* vtable;
 } Trait;
 
 typedef struct ValueMap {
@@ -848,6 +855,8 @@ typedef struct VMC {
 
     ZCyList context_vars; // ContextVar
 
+    ZCyList vtables; // ZSlice of FuncSymbol
+
     TypeEntry* typesPtr;
     size_t typesLen;
 
@@ -855,6 +864,9 @@ typedef struct VMC {
     u32 debugPc;
     u32 trace_indent;
 
+    // Whether branch and loop outcomes are reported to `VM.profile`.
+    bool profiling;
+
 #if TRACK_GLOBAL_RC
     size_t refCounts;
 #endif
@@ -938,6 +950,8 @@ ValueResult zAllocListDyn(VM* vm, Value* elemStart, uint8_t nelems);
 ValueResult zAllocArray(VM* vm, TypeId type_id, Value* elemStart, uint8_t nelems);
 double zOtherToF64(Value val);
 CallObjSymResult zCallObjSym(VM* vm, Inst* pc, Value* stack, Value recv, TypeId typeId, u16 method, u8 startLocal, u8 numArgs);
+void zProfileBranch(VM* vm, Inst* pc, bool cond);
+void zProfileLoop(VM* vm, Inst* pc, u32 runs, u32 iters);
 ValueResult zAllocFiber(VM* vm, uint32_t pc, Value* args, uint8_t nargs, uint8_t argDst, uint8_t initialStackSize);
 PcFp zPushFiber(VM* vm, size_t curFiberEndPc, Value* curStack, Fiber* fiber, uint8_t parentDstLocal);
 PcFpOff zPopFiber(VM* vm, size_t curFiberEndPc, Value* curStack, Value retValue);
@@ -67,6 +67,12 @@ const VMC = extern struct {
     context_vars_cap: usize,
     context_vars_len: usize,
 
+    /// vtables for trait impls, each vtable contains copies of the impl's func symbols
+    /// so that a trait call does not go through `funcSyms`.
+    vtables: [*][]rt.FuncSymbol,
+    vtables_cap: usize,
+    vtables_len: usize,
+
     /// Types.
     types: [*]const types.Type,
     types_len: usize,
@@ -79,6 +85,9 @@ const VMC = extern struct {
 
     trace_indent: u32,
 
+    /// Whether branch and loop outcomes are reported to `VM.profile`.
+    profiling: bool,
+
     refCounts: if (cy.TrackGlobalRC) usize else void,
 
     pub fn getVarSyms(self: *VMC) *cy.List(rt.VarSym) {
@@ -89,6 +98,10 @@ const VMC = extern struct {
         return @ptrCast(&self.context_vars);
     }
 
+    pub fn getVtables(self: *VMC) *cy.List([]rt.FuncSymbol) {
+        return @ptrCast(&self.vtables);
+    }
+
     pub fn getFields(self: *VMC) *cy.List(vmc.Field) {
         return @ptrCast(&self.fields);
     }
@@ -109,12 +122,37 @@ pub const VM = struct {
     c: VMC,
 
     /// Holds unique heap string interns (*Astring, *Ustring).
-    /// By default, small strings (at most 64 bytes) are interned.
+    /// Small string constants (at most 64 bytes) are interned. Runtime strings are only
+    /// interned on demand, see `heap.retainOrInternString`.
     strInterns: std.StringHashMapUnmanaged(*HeapObject),
 
+    /// Rune checkpoint indexes for large ustrings, built on the first rune seek.
+    /// Entries are removed when the string is freed.
+    ustrRuneIndexes: std.AutoHashMapUnmanaged(*HeapObject, cy.string.RuneIndex),
+    /// Amortizes sequential rune seeks on ustrings without an index.
+    ustrRuneCursor: cy.string.RuneCursor,
+
+    /// When set, records the receiver types seen at dynamic method call sites,
+    /// branch outcomes and loop trip counts. Set with `setProfile`.
+    /// Not owned by the VM.
+    profile: ?*cy.Profile,
+
     /// Object heap pages.
     heapPages: cy.List(*cy.heap.HeapPage),
+    /// Fully free pages are released after a gc run while there are more than `heapMinPages`.
+    heapMinPages: usize,
+    /// Live objects allocated outside of heap pages.
+    numExternalObjects: usize,
+    /// Recycled external object blocks, one list per `heap.ExternalSizeClasses`.
+    externalFreeLists: [cy.heap.ExternalSizeClasses.len]cy.heap.ExternalFreeList,
+    /// Recycled fiber stacks, one list per `fiber.StackSizeClasses`.
+    fiberStackFreeLists: [cy.fiber.StackSizeClasses.len]cy.fiber.StackFreeList,
+    /// Stack lengths that fibers grew to, keyed by their entry pc.
+    fiberStackLens: std.AutoHashMapUnmanaged(u32, u32),
     heapFreeHead: ?*HeapObject,
+    /// Current bump span detached from the free list. Allocation takes `heapBumpPtr` until it reaches `heapBumpEnd`.
+    heapBumpPtr: [*]HeapObject,
+    heapBumpEnd: [*]HeapObject,
     /// Trace mode.
     heapFreeTail: ?*HeapObject,
 
@@ -163,9 +201,6 @@ pub const VM = struct {
     /// `queueTask` appends tasks here.
     ready_tasks: std.fifo.LinearFifo(cy.heap.AsyncTask, .Dynamic),
 
-    /// vtables for trait impls, each vtable contains func ids.
-    vtables: cy.List([]const u32),
-
     /// This is needed for reporting since a method entry can be empty.
     methods: cy.List(rt.Method),
     debugTable: []const cy.DebugSym,
@@ -237,11 +272,21 @@ pub const VM = struct {
             .emptyString = undefined,
             .placeholder = undefined,
             .strInterns = .{},
+            .ustrRuneIndexes = .{},
+            .ustrRuneCursor = .{ .obj = null, .byte_idx = 0, .rune_idx = 0 },
+            .profile = null,
             .staticObjects = .{},
             .names = .{},
             .nameMap = .{},
             .heapPages = .{},
+            .heapMinPages = cy.heap.DefaultMinHeapPages,
+            .numExternalObjects = 0,
+            .externalFreeLists = [_]cy.heap.ExternalFreeList{.{ .head = null, .len = 0 }} ** cy.heap.ExternalSizeClasses.len,
+            .fiberStackFreeLists = [_]cy.fiber.StackFreeList{.{ .head = null, .len = 0 }} ** cy.fiber.StackSizeClasses.len,
+            .fiberStackLens = .{},
             .heapFreeHead = null,
+            .heapBumpPtr = undefined,
+            .heapBumpEnd = undefined,
             .heapFreeTail = if (cy.Trace) null else undefined,
             .cyclableHead = if (cy.hasGC) @ptrCast(&dummyCyclableHead) else {},
             .c = .{
@@ -260,6 +305,9 @@ pub const VM = struct {
                 .context_vars = undefined,
                 .context_vars_cap = 0,
                 .context_vars_len = 0,
+                .vtables = undefined,
+                .vtables_cap = 0,
+                .vtables_len = 0,
                 .fields = undefined,
                 .fields_cap = 0,
                 .fields_len = 0,
@@ -271,6 +319,7 @@ pub const VM = struct {
                 .curFiber = undefined,
                 .debugPc = cy.NullId,
                 .trace_indent = 0,
+                .profiling = false,
             },
             .method_map = .{},
             .methods = .{},
@@ -314,7 +363,6 @@ pub const VM = struct {
             .num_cont_evals = 0,
             .last_bc_len = 0,
             .ready_tasks = std.fifo.LinearFifo(cy.heap.AsyncTask, .Dynamic).init(alloc),
-            .vtables = .{},
         };
         self.c.mainFiber.typeId = bt.Fiber | vmc.CYC_TYPE_MASK;
         self.c.mainFiber.rc = 1;
@@ -356,6 +404,8 @@ pub const VM = struct {
         if (cy.Trace) {
             self.heapFreeTail = list.tail;
         }
+        self.heapBumpPtr = @ptrCast(list.head);
+        self.heapBumpEnd = self.heapBumpPtr;
 
         const data = try self.alloc.create(cy.builtins.BuiltinsData);
         try self.data.put(self.alloc, "builtins", data);
@@ -504,6 +554,8 @@ pub const VM = struct {
                 self.alloc.destroy(page);
             }
             self.heapPages.deinit(self.alloc);
+            cy.heap.deinitExternalFreeLists(self);
+            cy.fiber.deinitStackFreeLists(self);
         }
 
         self.c.types_len = 0;
@@ -525,10 +577,26 @@ pub const VM = struct {
         if (reset) {
             self.u8Buf.clearRetainingCapacity();
             self.strInterns.clearRetainingCapacity();
+            self.fiberStackLens.clearRetainingCapacity();
+            if (self.profile) |profile| {
+                profile.clear();
+            }
         } else {
             self.u8Buf.deinit(self.alloc);
             self.strInterns.deinit(self.alloc);
+            self.fiberStackLens.deinit(self.alloc);
+        }
+
+        var rune_iter = self.ustrRuneIndexes.valueIterator();
+        while (rune_iter.next()) |index| {
+            index.deinit(self.alloc);
         }
+        if (reset) {
+            self.ustrRuneIndexes.clearRetainingCapacity();
+        } else {
+            self.ustrRuneIndexes.deinit(self.alloc);
+        }
+        self.ustrRuneCursor.obj = null;
 
         if (cy.Trace) {
             if (reset) {
@@ -553,13 +621,13 @@ pub const VM = struct {
             self.inlineSaves.deinit(self.alloc);
         }
 
-        for (self.vtables.items()) |vtable| {
+        for (self.c.getVtables().items()) |vtable| {
             self.alloc.free(vtable);
         }
         if (reset) {
-            self.vtables.clearRetainingCapacity();
+            self.c.getVtables().clearRetainingCapacity();
         } else {
-            self.vtables.deinit(self.alloc);
+            self.c.getVtables().deinit(self.alloc);
         }
 
         for (self.names.items()) |name| {
@@ -625,6 +693,11 @@ pub const VM = struct {
         return res;
     }
 
+    pub fn setProfile(self: *VM, profile: ?*cy.Profile) void {
+        self.profile = profile;
+        self.c.profiling = profile != null;
+    }
+
     pub fn resetVM(self: *VM) !void {
         self.deinit(true);
         try @call(.never_inline, cy.bindings.bindCore, .{self});
@@ -913,83 +986,31 @@ pub const VM = struct {
     };
 
     pub fn callFunc(vm: *VM, func: Value, args: []const Value, config: CallFuncConfig) !Value {
-        const fpOff = cy.fiber.getStackOffset(vm.c.stack, vm.c.framePtr);
-        const ret = vm.getNewCallFuncRet();
+        var prepared = try vm.prepareCall(func, @intCast(args.len));
+        return prepared.callExt(vm, args, config.from_external);
+    }
 
-        const pc = vm.c.pc;
+    /// Sets up a re-entry call to `func` that can be invoked repeatedly from the same host function.
+    /// The callee slot, return offset and stack capacity are resolved once, so each
+    /// `PreparedCall.call` only copies the args before running the callee.
+    pub fn prepareCall(vm: *VM, func: Value, nargs: u8) !PreparedCall {
+        const fp_off = cy.fiber.getStackOffset(vm.c.stack, vm.c.framePtr);
+        const ret = vm.getNewCallFuncRet();
 
         // Since the compiler isn't aware of a re-entry call, it can not predetermine the stack size required
         // for the arguments.
-        try cy.fiber.ensureTotalStackCapacity(vm, fpOff + ret + CallArgStart + args.len);
+        try cy.fiber.ensureTotalStackCapacity(vm, fp_off + ret + CallArgStart + nargs);
         // Should the stack grow, update pointer.
-        vm.c.framePtr = vm.c.stack + fpOff;
-
-        // Copy callee + args to a new blank frame.
-        vm.c.framePtr[ret + CalleeStart] = func;
-        @memcpy(vm.c.framePtr[ret+CallArgStart..ret+CallArgStart+args.len], args);
-
-        if (cy.Trace) {
-            vm.c.trace_indent += 1;
-        }
-
-        // Pass in an arbitrary `pc` to reuse the same `call` used by the VM.
-        const pcsp = try call(vm, vm.c.pc, vm.c.framePtr, func, ret, @intCast(args.len), false);
-        vm.c.framePtr = pcsp.fp;
-        vm.c.pc = pcsp.pc;
-
-        // Only user funcs start eval loop.
-        if (!cy.value.isHostFunc(vm, func)) {
-            if (config.from_external) {
-                @call(.never_inline, evalLoopGrowStack, .{vm, true}) catch |err| {
-                    if (err == error.Panic) {
-                        // Dump for now.
-                        const frames = try cy.debug.allocStackTrace(vm, vm.c.getStack(), vm.compactTrace.items());
-                        defer vm.alloc.free(frames);
-
-                        const w = cy.fmt.lockStderrWriter();
-                        defer cy.fmt.unlockPrint();
-                        const msg = try cy.debug.allocPanicMsg(vm);
-                        defer vm.alloc.free(msg);
-                        try fmt.format(w, "{}\n\n", &.{v(msg)});
-                        try cy.debug.writeStackFrames(vm, w, frames);
-                    }
-                    logger.tracev("{}", .{err});
-                    return error.Panic;
-                    // return builtins.prepThrowZError(@ptrCast(vm), err, @errorReturnTrace());
-                };
-            } else {
-                @call(.never_inline, evalLoopGrowStack, .{vm, false}) catch |err| {
-                    if (err == error.Panic) {
-                        return err;
-                    } else {
-                        return error.Unexpected;
-                    }
-                };
-            }
-            // Return to dyn frame since ret inst does not unwind for cont=false.
-            vm.c.pc = vm.c.framePtr[2].retPcPtr;
-            vm.c.framePtr = vm.c.framePtr[3].retFramePtr;
-        } else {
-            if (cy.Trace) {
-                vm.c.trace_indent -= 1;
-            }
-        }
+        vm.c.framePtr = vm.c.stack + fp_off;
 
-        // Perform ret_dyn.
-        const final_ret = 5 + args.len;
-        const ret_v = vm.c.framePtr[final_ret];
-        const ret_t = vm.c.framePtr[1].call_info.payload & 0x7fffffff;
-        var res: Value = undefined;
-        if (vm.sema.isUnboxedType(ret_t)) {
-            res = zBox(vm, ret_v, ret_t);
-        } else {
-            res = ret_v;
-        }
-
-        // Restore pc/sp.
-        vm.c.framePtr = vm.c.stack + fpOff;
-        vm.c.pc = pc;
-        return res;
+        return .{
+            .func = func,
+            .pc = vm.c.pc,
+            .fp_off = fp_off,
+            .ret = ret,
+            .nargs = nargs,
+            .is_host = cy.value.isHostFunc(vm, func),
+        };
     }
 
     pub fn addAnonymousStruct(self: *VM, parent: *cy.Sym, baseName: []const u8, uniqId: u32, fields: []const []const u8) !cy.TypeId {
@@ -1839,6 +1860,7 @@ test "vm internals." {
     try t.eq(@offsetOf(VMC, "consts"), @offsetOf(vmc.VMC, "constPtr"));
     try t.eq(@offsetOf(VMC, "varSyms"), @offsetOf(vmc.VMC, "varSyms"));
     try t.eq(@offsetOf(VMC, "context_vars"), @offsetOf(vmc.VMC, "context_vars"));
+    try t.eq(@offsetOf(VMC, "vtables"), @offsetOf(vmc.VMC, "vtables"));
     try t.eq(@offsetOf(VMC, "fields"), @offsetOf(vmc.VMC, "fields"));
     try t.eq(@offsetOf(VMC, "curFiber"), @offsetOf(vmc.VMC, "curFiber"));
     try t.eq(@offsetOf(VMC, "mainFiber"), @offsetOf(vmc.VMC, "mainFiber"));
@@ -2157,6 +2179,99 @@ fn preCallDyn(vm: *VM, pc: [*]cy.Inst, fp: [*]Value, nargs: u8, ret: u8, final_r
     return sig.ret;
 }
 
+/// A re-entry call created by `VM.prepareCall`.
+/// Only valid while the host function that prepared it is still running.
+pub const PreparedCall = struct {
+    func: Value,
+    pc: [*]cy.Inst,
+    fp_off: usize,
+    ret: u8,
+    nargs: u8,
+    is_host: bool,
+
+    /// Args are borrowed and must be boxed. The result is owned by the caller.
+    pub fn call(self: *const PreparedCall, vm: *VM, args: []const Value) !Value {
+        return self.callExt(vm, args, false);
+    }
+
+    fn callExt(self: *const PreparedCall, vm: *VM, args: []const Value, from_external: bool) !Value {
+        if (cy.Trace) {
+            if (args.len != self.nargs) {
+                @panic("Unexpected.");
+            }
+        }
+        // The stack may have grown during a previous call.
+        const fp = vm.c.stack + self.fp_off;
+
+        // Copy callee + args to a new blank frame.
+        fp[self.ret + CalleeStart] = self.func;
+        @memcpy(fp[self.ret+CallArgStart..self.ret+CallArgStart+args.len], args);
+
+        if (cy.Trace) {
+            vm.c.trace_indent += 1;
+        }
+
+        // Pass in an arbitrary `pc` to reuse the same `call` used by the VM.
+        const pcsp = try call(vm, self.pc, fp, self.func, self.ret, self.nargs, false);
+        vm.c.framePtr = pcsp.fp;
+        vm.c.pc = pcsp.pc;
+
+        // Only user funcs start eval loop.
+        if (!self.is_host) {
+            if (from_external) {
+                @call(.never_inline, evalLoopGrowStack, .{vm, true}) catch |err| {
+                    if (err == error.Panic) {
+                        // Dump for now.
+                        const frames = try cy.debug.allocStackTrace(vm, vm.c.getStack(), vm.compactTrace.items());
+                        defer vm.alloc.free(frames);
+
+                        const w = cy.fmt.lockStderrWriter();
+                        defer cy.fmt.unlockPrint();
+                        const msg = try cy.debug.allocPanicMsg(vm);
+                        defer vm.alloc.free(msg);
+                        try fmt.format(w, "{}\n\n", &.{v(msg)});
+                        try cy.debug.writeStackFrames(vm, w, frames);
+                    }
+                    logger.tracev("{}", .{err});
+                    return error.Panic;
+                    // return builtins.prepThrowZError(@ptrCast(vm), err, @errorReturnTrace());
+                };
+            } else {
+                @call(.never_inline, evalLoopGrowStack, .{vm, false}) catch |err| {
+                    if (err == error.Panic) {
+                        return err;
+                    } else {
+                        return error.Unexpected;
+                    }
+                };
+            }
+            // Return to dyn frame since ret inst does not unwind for cont=false.
+            vm.c.pc = vm.c.framePtr[2].retPcPtr;
+            vm.c.framePtr = vm.c.framePtr[3].retFramePtr;
+        } else {
+            if (cy.Trace) {
+                vm.c.trace_indent -= 1;
+            }
+        }
+
+        // Perform ret_dyn.
+        const final_ret = 5 + args.len;
+        const ret_v = vm.c.framePtr[final_ret];
+        const ret_t = vm.c.framePtr[1].call_info.payload & 0x7fffffff;
+        var res: Value = undefined;
+        if (vm.sema.isUnboxedType(ret_t)) {
+            res = zBox(vm, ret_v, ret_t);
+        } else {
+            res = ret_v;
+        }
+
+        // Restore pc/sp.
+        vm.c.framePtr = vm.c.stack + self.fp_off;
+        vm.c.pc = self.pc;
+        return res;
+    }
+};
+
 /// See `reserveFuncParams` for stack layout.
 /// numArgs does not include the callee.
 /// Arguments are always boxed values, so they need to be unboxed when calling a typed function
@@ -2877,9 +2992,7 @@ fn zUnbox(vm: *VM, val: cy.Value, type_id: cy.TypeId) callconv(.C) cy.Value {
 fn zCallTrait(vm: *VM, pc: [*]cy.Inst, framePtr: [*]Value, vtable_idx: u16, ret: u8) callconv(.C) vmc.PcFpResult {
     // Get func from vtable.
     const trait = framePtr[ret+4].asHeapObject();
-    const vtable = vm.vtables.buf[trait.trait.vtable];
-    const func_id = vtable[vtable_idx];
-    const func = vm.funcSyms.buf[func_id];
+    const func = trait.trait.vtable[vtable_idx];
 
     // Unwrap impl to first arg slot.
     framePtr[ret+5] = trait.trait.impl;
@@ -3068,6 +3181,14 @@ fn zAllocListDyn(vm: *cy.VM, elemStart: [*]const Value, nElems: u8) callconv(.C)
     };
 }
 
+fn zProfileBranch(vm: *cy.VM, pc: [*]cy.Inst, cond: bool) callconv(.C) void {
+    vm.profile.?.recordBranch(vm.alloc, getInstOffset(vm, pc), cond) catch cy.fatal();
+}
+
+fn zProfileLoop(vm: *cy.VM, pc: [*]cy.Inst, runs: u32, iters: u32) callconv(.C) void {
+    vm.profile.?.recordLoop(vm.alloc, getInstOffset(vm, pc), runs, iters) catch cy.fatal();
+}
+
 fn zOtherToF64(val: Value) callconv(.C) f64 {
     return val.otherToF64() catch fatal();
 }
@@ -3076,6 +3197,11 @@ fn zCallObjSym(
     vm: *cy.VM, pc: [*]cy.Inst, stack: [*]Value, recv: Value,
     typeId: cy.TypeId, method: u16, ret: u8, numArgs: u8,
 ) callconv(.C) vmc.CallObjSymResult {
+    if (vm.profile) |profile| {
+        profile.recordRecv(vm.alloc, getInstOffset(vm, pc), typeId) catch {
+            return .{ .pc = undefined, .stack = undefined, .code = vmc.RES_CODE_UNKNOWN };
+        };
+    }
     const args = stack[ret+CallArgStart+1..ret+CallArgStart+1+numArgs-1];
     if (vm.getCompatMethodFunc(typeId, method, args)) |func| {
         const mb_res = callMethod(vm, pc, stack, func, typeId, numArgs, ret) catch |err| {
@@ -3464,6 +3590,8 @@ comptime {
         @export(zCallTrait, .{ .name = "zCallTrait", .linkage = .strong });
         @export(zCallSymDyn, .{ .name = "zCallSymDyn", .linkage = .strong });
         @export(zCallObjSym, .{ .name = "zCallObjSym", .linkage = .strong });
+        @export(zProfileBranch, .{ .name = "zProfileBranch", .linkage = .strong });
+        @export(zProfileLoop, .{ .name = "zProfileLoop", .linkage = .strong });
         @export(zOpMatch, .{ .name = "zOpMatch", .linkage = .strong });
         @export(zOpCodeName, .{ .name = "zOpCodeName", .linkage = .strong });
         @export(zLog, .{ .name = "zLog", .linkage = .strong });
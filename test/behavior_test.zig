@@ -251,6 +251,7 @@ if (!aot) {
     }
     run.case("modules/core.cy");
     run.case("modules/cy.cy");
+    run.case("modules/json.cy");
     run.case("modules/math.cy");
     run.case("modules/test_eq_panic.cy");
     run.case("modules/test.cy");
@@ -293,6 +294,7 @@ if (!aot) {
     run.case("core/ints.cy");
     run.case("core/int_unsupported_notation_error.cy");
     run.case("core/list_neg_index_oob_panic.cy");
+    run.case("core/list_values.cy");
     run.case("core/lists.cy");
     run.case("core/logic_ops.cy");
     run.case("core/map_index_panic.cy");
@@ -310,17 +312,25 @@ if (!aot) {
     run.case("core/string_new_line_error.cy");
     run.case("core/string_interpolation.cy");
 }
+    run.case("core/string_append.cy");
     run.case("core/strings.cy");
     run.case("core/strings_ascii.cy");
     run.case("core/strings_utf8.cy");
     run.case("core/string_slices_ascii.cy");
     run.case("core/string_slices_utf8.cy");
 if (!aot) {
+    run.case("core/string_builder.cy");
+    run.case("core/string_split.cy");
+if (!cy.isWasm) {
+    run.case("core/string_too_long.cy");
+}
     run.case("core/symbols.cy");
     run.case("core/table.cy");
     run.case("core/table_access_panic.cy"); 
     run.case("core/tag_lit.cy");
 }
+    run.case("core/prim_binary_ops.cy");
+    run.case("core/unary_ops.cy");
 
     run.case("vars/context_var_redeclare_error.cy");
     run.case("vars/context_var.cy");
@@ -365,7 +375,9 @@ if (!aot) {
     run.case("control_flow/for_range.cy");
     run.case("control_flow/if_expr.cy");
     run.case("control_flow/if_expr_error.cy");
+}
     run.case("control_flow/if_stmt.cy");
+if (!aot) {
     run.case("control_flow/if_unwrap.cy");
     run.case("control_flow/switch.cy");
     run.case("control_flow/switch_error.cy");
@@ -421,11 +433,27 @@ test "Compile." {
     }
 
     // benchmarks.
+    try compileCase(.{}, "bench/closure/closure.cy");
+    try compileCase(.{}, "bench/cyon/cyon.cy");
+    try compileCase(.{}, "bench/error/throw.cy");
+    try compileCase(.{}, "bench/ffi/ffi.cy");
     try compileCase(.{}, "bench/fib/fib.cy");
     try compileCase(.{}, "bench/fiber/fiber.cy");
+    try compileCase(.{}, "bench/fiber/short.cy");
     try compileCase(.{}, "bench/for/for.cy");
+    try compileCase(.{}, "bench/heap/alloc.cy");
     try compileCase(.{}, "bench/heap/heap.cy");
+    try compileCase(.{}, "bench/json/json.cy");
+    try compileCase(.{}, "bench/list/sort.cy");
+    try compileCase(.{}, "bench/string/append.cy");
+    try compileCase(.{}, "bench/string/builder.cy");
+    try compileCase(.{}, "bench/string/csv.cy");
     try compileCase(.{}, "bench/string/index.cy");
+    try compileCase(.{}, "bench/string/join.cy");
+    try compileCase(.{}, "bench/string/rune_index.cy");
+    try compileCase(.{}, "bench/string/template.cy");
+    try compileCase(.{}, "bench/string/unique.cy");
+    try compileCase(.{}, "bench/trait/trait.cy");
 }
 
 fn compileCase(config: Config, path: []const u8) !void {
@@ -457,6 +485,107 @@ test "Multiple evals with same VM." {
     }, src);
 }
 
+test "Profile round trip." {
+    // Only the bytecode interpreter records a profile.
+    if (cy.fromTestBackend(build_options.testBackend) != c.BackendVM) {
+        return error.SkipZigTest;
+    }
+    var profile = cy.Profile.init();
+    defer profile.deinit(t.alloc);
+
+    try eval(.{ .profile = &profile },
+        \\var n = 0
+        \\for 0..100 -> i:
+        \\    if i < 95:
+        \\        n += 1
+        \\    else i == 99:
+        \\        n += 10
+        \\for 0..0:
+        \\    n += 1
+    , struct { fn func(run: *VMrunner, res: EvalResult) !void {
+        _ = try res.getValue();
+        const vm = run.internal();
+
+        var buf: std.ArrayListUnmanaged(u8) = .{};
+        defer buf.deinit(t.alloc);
+        try vm.profile.?.write(vm, buf.writer(t.alloc));
+
+        var hints = try cy.profile.Hints.init(t.alloc, buf.items);
+        defer hints.deinit();
+
+        const branch = hints.branches.get("main:3:5").?;
+        try t.eq(branch.trues, 95);
+        try t.eq(branch.falses, 5);
+        try t.eq(branch.bias(), true);
+
+        const else_branch = hints.branches.get("main:5:5").?;
+        try t.eq(else_branch.trues, 1);
+        try t.eq(else_branch.falses, 4);
+        try t.eq(else_branch.bias(), null);
+
+        const loop = hints.loops.get("main:2:1").?;
+        try t.eq(loop.runs, 1);
+        try t.eq(loop.iters, 100);
+        const empty_loop = hints.loops.get("main:7:1").?;
+        try t.eq(empty_loop.runs, 1);
+        try t.eq(empty_loop.iters, 0);
+    }}.func);
+}
+
+test "List.sort with a failing comparator." {
+    // The host sort is only bound for the VM.
+    if (cy.isAot(cy.fromTestBackend(build_options.testBackend))) {
+        return error.SkipZigTest;
+    }
+
+    const Expect = struct {
+        fn panicWith(run: *VMrunner, res: EvalResult, msg: []const u8) !void {
+            try t.eq(res.code, c.ErrorPanic);
+            const report = run.vm.newPanicSummary();
+            defer run.vm.free(report);
+            if (std.mem.indexOf(u8, report, msg) == null) {
+                std.debug.print("expected panic with `{s}`, found:\n{s}\n", .{msg, report});
+                return error.TestUnexpectedError;
+            }
+        }
+    };
+
+    // Panic from the comparator.
+    try eval(.{ .silent = true },
+        \\var a = {3, 1, 2, 5, 4}
+        \\var less = func(x dyn, y dyn) bool:
+        \\    if x == 5:
+        \\        panic('bad compare')
+        \\    return x < y
+        \\a.sort(less)
+    , struct { fn func(run: *VMrunner, res: EvalResult) !void {
+        try Expect.panicWith(run, res, "bad compare");
+    }}.func);
+
+    // Error thrown from the comparator.
+    try eval(.{ .silent = true },
+        \\var a = List[int]{3, 1, 2, 5, 4}
+        \\var less = func(x int, y int) bool:
+        \\    if x == 5:
+        \\        throw error.BadCompare
+        \\    return x < y
+        \\a.sort(less)
+    , struct { fn func(run: *VMrunner, res: EvalResult) !void {
+        try Expect.panicWith(run, res, "BadCompare");
+    }}.func);
+
+    // The comparator modifies the list.
+    try eval(.{ .silent = true },
+        \\var a = List[int]{3, 1, 2}
+        \\var less = func(x int, y int) bool:
+        \\    a.append(x)
+        \\    return x < y
+        \\a.sort(less)
+    , struct { fn func(run: *VMrunner, res: EvalResult) !void {
+        try Expect.panicWith(run, res, "List was modified during sort.");
+    }}.func);
+}
+
 test "FFI." {
     if (cy.isWasm) {
         return;
@@ -0,0 +1,19 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Plain C baseline for ffi.cy.
+int main() {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long sum = 0;
+    long (*volatile f)(long) = labs;
+    for (long i = 0; i < 10000000; i += 1) {
+        sum += f(-i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+    printf("c: %f\n", ms);
+    printf("%ld\n", sum);
+    return 0;
+}
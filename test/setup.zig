@@ -34,6 +34,9 @@ pub const Config = struct {
 
     chdir: ?[]const u8 = null,
 
+    /// Records into the profile while the script runs. It can be written from the eval callback.
+    profile: ?*cy.Profile = null,
+
     pub fn withReload(self: Config) Config {
         var new = self;
         new.reload = true;
@@ -195,6 +198,8 @@ pub const VMrunner = struct {
         }
 
         run.ctx = config.ctx;
+        run.internal().setProfile(config.profile);
+        defer run.internal().setProfile(null);
         if (config.preEval) |preEval| {
             preEval(run);
         }
@@ -211,7 +216,7 @@ pub const VMrunner = struct {
         const c_config = c.EvalConfig{
             .single_run = false,
             .file_modules = config.enableFileModules,
-            .gen_all_debug_syms = config.debug,
+            .gen_all_debug_syms = config.debug or config.profile != null,
             .backend = cy.fromTestBackend(build_options.testBackend),
             .spawn_exe = false,
             .reload = config.reload,